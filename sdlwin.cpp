@@ -1,53 +1,300 @@
 #include "sdlwin.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <charconv>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLW_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SDL_TTF_VERSION_ATLEAST
+#if SDL_TTF_VERSION_ATLEAST(2, 20, 0)
+#define SDLW_TTF_SHAPING
+#endif
+#endif
+#include <limits>
+#include <cmath>
+#include <chrono>
+#include <filesystem>
+#include <cerrno>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace sdlw {
 
     inline constexpr static int sgn(int x) { return (x < 0) - (x > 0); }
 
-    Graphics::Graphics(int w, int h) : w(w), h(h), valid(initItems(w, h)) {}
+    static double elapsedMs(Uint64 since) {
+        return 1000. * (SDL_GetPerformanceCounter() - since) / SDL_GetPerformanceFrequency();
+    }
+
+    // decodes one code point and advances i, invalid bytes decode as themselves
+    static Uint32 nextCodepoint(std::string_view text, std::size_t &i) {
+        const Uint8 lead = (Uint8)text[i++];
+        const int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        if (!extra || i + extra > text.size()) return lead;
+        Uint32 cp = lead & (0x3F >> extra);
+        for (int k = 0; k < extra; ++k)
+            cp = (cp << 6) | ((Uint8)text[i++] & 0x3F);
+        return cp;
+    }
+
+    static std::string encodeCodepoint(Uint32 cp) {
+        std::string out;
+        if (cp < 0x80)
+            out += (char)cp;
+        else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        return out;
+    }
+
+    // a stretch of text with one script and direction, [begin, end) in bytes;
+    // script is nullptr while the run holds only neutral characters
+    struct TextRun {
+        std::size_t begin, end;
+        const char *script;
+        bool rtl;
+    };
+
+    // split where the script or direction changes, applied run by run before
+    // rendering when SDL_ttf shapes with HarfBuzz; spaces, digits and punctuation
+    // stay with the run they follow
+    static std::vector<TextRun> textRuns(std::string_view text) {
+        if (text.empty()) return {};
+#ifdef SDLW_TTF_SHAPING
+        struct Range { Uint32 first, last; const char *script; bool rtl; };
+        static constexpr Range ranges[] = {
+            { 0x0590, 0x05FF, "Hebr", true },
+            { 0x0600, 0x06FF, "Arab", true },
+            { 0x0750, 0x077F, "Arab", true },
+            { 0x0900, 0x097F, "Deva", false },
+            { 0x0980, 0x09FF, "Beng", false },
+            { 0x0A00, 0x0A7F, "Guru", false },
+            { 0x0B80, 0x0BFF, "Taml", false },
+            { 0x0E00, 0x0E7F, "Thai", false },
+            { 0xFB1D, 0xFB4F, "Hebr", true },
+            { 0xFB50, 0xFDFF, "Arab", true },
+            { 0xFE70, 0xFEFF, "Arab", true },
+        };
+        static constexpr Range latin{ 0, 0, "Latn", false };
+        std::vector<TextRun> runs;
+        for (std::size_t i = 0; i < text.size();) {
+            const std::size_t at = i;
+            const Uint32 cp = nextCodepoint(text, i);
+            const Range *found = nullptr;
+            for (const auto &range : ranges)
+                if (cp >= range.first && cp <= range.last)
+                    found = &range;
+            const bool neutral = cp < 0x80 ? (cp | 0x20) - 'a' >= 26 : cp >= 0x2000 && cp <= 0x206F;
+            if (!found && !neutral)
+                found = &latin;
+
+            if (runs.empty())
+                runs.push_back({ at, at, nullptr, false });
+            TextRun &run = runs.back();
+            if (found && run.script && std::strcmp(found->script, run.script) != 0)
+                runs.push_back({ at, at, found->script, found->rtl });
+            else if (found && !run.script) {
+                run.script = found->script;
+                run.rtl = found->rtl;
+            }
+            runs.back().end = i;
+        }
+        return runs;
+#else
+        return { { 0, text.size(), nullptr, false } };
+#endif
+    }
+
+    static void shapeRun(TTF_Font *font, const TextRun &run) {
+#ifdef SDLW_TTF_SHAPING
+        TTF_SetFontScriptName(font, run.script ? run.script : "Latn");
+        TTF_SetFontDirection(font, run.rtl ? TTF_DIRECTION_RTL : TTF_DIRECTION_LTR);
+#else
+        (void)font, (void)run;
+#endif
+    }
+
+    // each run shaped and rendered on its own, then placed side by side; the
+    // first run's direction is the text's, so right-to-left text lays its runs
+    // out from the right. Not a full bidi algorithm, runs never reorder inside.
+    static SDL_Surface *renderRuns(TTF_Font *font, std::string_view text, SDL_Color color) {
+        const std::vector<TextRun> runs = textRuns(text);
+        if (runs.size() <= 1) {
+            if (!runs.empty())
+                shapeRun(font, runs.front());
+            return TTF_RenderUTF8_Solid(font, std::string(text).c_str(), color);
+        }
+        std::vector<SDL_Surface *> parts;
+        int w = 0, h = 0;
+        for (const auto &run : runs) {
+            shapeRun(font, run);
+            const std::string str(text.substr(run.begin, run.end - run.begin));
+            SDL_Surface *part = TTF_RenderUTF8_Solid(font, str.c_str(), color);
+            if (part && part->format->BytesPerPixel != 1) {
+                SDL_FreeSurface(part);
+                part = nullptr;
+            }
+            if (!part) continue;
+            parts.push_back(part);
+            w += part->w;
+            h = std::max(h, part->h);
+        }
+        if (runs.front().rtl)
+            std::reverse(parts.begin(), parts.end());
+
+        SDL_Surface *surface = parts.empty() ? nullptr
+            : SDL_CreateRGBSurfaceWithFormat(0, w, h, 8, SDL_PIXELFORMAT_INDEX8);
+        if (surface) {
+            // the same palette and colorkey as TTF_RenderUTF8_Solid's
+            const SDL_Palette *palette = parts.front()->format->palette;
+            SDL_SetPaletteColors(surface->format->palette, palette->colors, 0,
+                std::min(palette->ncolors, surface->format->palette->ncolors));
+            SDL_SetColorKey(surface, SDL_TRUE, 0);
+            SDL_FillRect(surface, NULL, 0);
+            int x = 0;
+            for (SDL_Surface *part : parts) {
+                for (int y = 0; y < part->h; ++y)
+                    std::memcpy((Uint8 *)surface->pixels + 1LL * y * surface->pitch + x,
+                        (const Uint8 *)part->pixels + 1LL * y * part->pitch, part->w);
+                x += part->w;
+            }
+        }
+        for (SDL_Surface *part : parts)
+            SDL_FreeSurface(part);
+        return surface;
+    }
+
+    // the size renderRuns' surface has
+    static void measureRuns(TTF_Font *font, std::string_view text, int &w, int &h) {
+        w = h = 0;
+        for (const auto &run : textRuns(text)) {
+            shapeRun(font, run);
+            int rw = 0, rh = 0;
+            TTF_SizeUTF8(font, std::string(text.substr(run.begin, run.end - run.begin)).c_str(), &rw, &rh);
+            w += rw;
+            h = std::max(h, rh);
+        }
+    }
+
+    // SDL_ttf shares one FreeType library between all fonts, opening and
+    // closing them is not thread-safe
+    static std::mutex fontMutex;
+
+    std::vector<Graphics *> Graphics::instances{};
+
+    Graphics::Graphics(int w, int h, bool headless) : w(w), h(h), valid(initItems(w, h, headless)) {
+        target = screen;
+        std::lock_guard<std::mutex> lock(fontMutex);
+        instances.push_back(this);
+    }
 
     Graphics::~Graphics() {
+        {
+            std::lock_guard<std::mutex> lock(fontMutex);
+            instances.erase(std::find(instances.begin(), instances.end(), this));
+        }
+        for (auto &[_, surface] : glyphs)
+            SDL_FreeSurface(surface);
+        for (auto &entry : texts)
+            SDL_FreeSurface(entry.surface);
+        for (auto &[_, font] : sizedFonts)
+            closeFont(font);
+        GlyphCache::flush();
         SDL_FreeSurface(screen);
-        SDL_DestroyTexture(scrtex);
-        SDL_DestroyWindow(window);
-        SDL_DestroyRenderer(renderer);
+        if (window) {
+            SDL_DestroyTexture(scrtex);
+            SDL_DestroyWindow(window);
+            SDL_DestroyRenderer(renderer);
+        }
     }
 
-    void Graphics::drawPixel(int x, int y, Color color) {
-        int64_t bpp = screen->format->BytesPerPixel;
-        Uint8 *p = (Uint8 *)screen->pixels + (1LL * y * screen->pitch + x * bpp);
+    void Painter::drawPixel(int x, int y, Color color) {
+        int64_t bpp = target->format->BytesPerPixel;
+        Uint8 *p = (Uint8 *)target->pixels + (1LL * y * target->pitch + x * bpp);
         *(Uint32 *)p = color;
     }
 
+    void Painter::drawLine(int x1, int y1, int x2, int y2, Color color) {
+        const SDL_Rect &clip = target->clip_rect;
+        const int dx = std::abs(x2 - x1), dy = -std::abs(y2 - y1);
+        const int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            if (x1 >= clip.x && x1 < clip.x + clip.w && y1 >= clip.y && y1 < clip.y + clip.h)
+                drawPixel(x1, y1, color);
+            if (x1 == x2 && y1 == y2) break;
+            const int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x1 += sx; }
+            if (e2 <= dx) { err += dx; y1 += sy; }
+        }
+    }
+
     bool error(const char *funcName, const char *msg) {
         std::cerr << funcName << " error: " << msg << '\n';
         return false;
     }
 
-    bool Graphics::initItems(int w, int h) {
-        constexpr int initFlags = SDL_INIT_EVERYTHING;
+    bool Graphics::initItems(int w, int h, bool headless) {
+        // audio, joystick, haptic and sensors cost startup time and are never used
+        constexpr Uint32 initFlags = SDL_INIT_VIDEO | SDL_INIT_EVENTS;
 
-        if (SDL_WasInit(0) != initFlags && SDL_Init(initFlags) != 0)
-            return error("SDL_Init", SDL_GetError());
-        if (SDL_CreateWindowAndRenderer(w, h, 0, &window, &renderer) != 0)
-            return error("SDL_CreateWindowAndRenderer", SDL_GetError());
+        // software surfaces need neither SDL_Init nor the main thread
+        if (!headless) {
+            if (SDL_WasInit(initFlags) != initFlags && SDL_InitSubSystem(initFlags) != 0)
+                return error("SDL_InitSubSystem", SDL_GetError());
+            if (SDL_CreateWindowAndRenderer(w, h, 0, &window, &renderer) != 0)
+                return error("SDL_CreateWindowAndRenderer", SDL_GetError());
 
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-        SDL_RenderSetLogicalSize(renderer, w, h);
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+            SDL_RenderSetLogicalSize(renderer, w, h);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            scrtex = SDL_CreateTexture(renderer,
+                SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        }
         screen = SDL_CreateRGBSurface(0, w, h, 32, 
             0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
-        scrtex = SDL_CreateTexture(renderer,
-            SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (!screen)
+            return error("SDL_CreateRGBSurface", SDL_GetError());
 
+        std::lock_guard<std::mutex> lock(fontMutex);
         if (!TTF_WasInit() && TTF_Init() != 0)
             return error("TTF_Init", TTF_GetError());
 
         return true;
     }
 
-    SDL_Color Graphics::sdlc(Color color) {
+    SDL_Color Painter::sdlc(Color color) {
         return SDL_Color{
             (uint8_t)((color >> 16) & 0xFF),
             (uint8_t)((color >> 8) & 0xFF),
@@ -55,11 +302,11 @@ namespace sdlw {
         };
     }
 
-    void Graphics::drawRect(SDL_Rect rect, Color color) {
-        SDL_FillRect(screen, &rect, color);
+    void Painter::drawRect(SDL_Rect rect, Color color) {
+        SDL_FillRect(target, &rect, color);
     }
 
-    void Graphics::drawRect(SDL_Rect rect, int borderW, Color color, Color borderColor) {
+    void Painter::drawRect(SDL_Rect rect, int borderW, Color color, Color borderColor) {
         const SDL_Rect borders[] = {
             {rect.x, rect.y, borderW, rect.h},
             {rect.x + rect.w - borderW, rect.y, borderW, rect.h},
@@ -67,797 +314,4915 @@ namespace sdlw {
             {rect.x, rect.y + rect.h - borderW, rect.w, borderW},
         };
 
-        SDL_FillRect(screen, &rect, color);
-        SDL_FillRects(screen, borders, _countof(borders), borderColor);
+        SDL_FillRect(target, &rect, color);
+        SDL_FillRects(target, borders, _countof(borders), borderColor);
     }
 
-    TTF_Font *Graphics::getFont(Font fontName, int fontSize) {
+    const char *Painter::fontPath(Font fontName) {
         switch (fontName)
         {
-        case Font::ARIAL: return TTF_OpenFont("./fonts/arial.ttf", fontSize);
-        case Font::SANS: return TTF_OpenFont("./fonts/sans.ttf", fontSize);
-        case Font::UBUNTU: return TTF_OpenFont("./fonts/ubuntu.ttf", fontSize);
-        case Font::COMIC_SANS: return TTF_OpenFont("./fonts/comic_sans.ttf", fontSize);
-        case Font::CONSOLAS: return TTF_OpenFont("./fonts/consolas.ttf", fontSize);
-        case Font::WINGDINGS: return TTF_OpenFont("./fonts/wingdings.ttf", fontSize);
-        case Font::WEBDINGS: return TTF_OpenFont("./fonts/webdings.ttf", fontSize);
+        case Font::ARIAL: return "./fonts/arial.ttf";
+        case Font::SANS: return "./fonts/sans.ttf";
+        case Font::UBUNTU: return "./fonts/ubuntu.ttf";
+        case Font::COMIC_SANS: return "./fonts/comic_sans.ttf";
+        case Font::CONSOLAS: return "./fonts/consolas.ttf";
+        case Font::WINGDINGS: return "./fonts/wingdings.ttf";
+        case Font::WEBDINGS: return "./fonts/webdings.ttf";
         default: return nullptr;
         }
     }
 
-    void Graphics::drawString(int x, int y, std::string_view text, int fontSize, Font fontName, Color color) {
-        if (TTF_Font *font = getFont(fontName, fontSize)) {
-            drawString(x, y, text, font, color);
-            TTF_CloseFont(font);
+    TTF_Font *Painter::getFont(Font fontName, int fontSize) {
+        if (TTF_Font *font = Preloader::takeFont(fontName, fontSize))
+            return font;
+        return openFont(fontName, fontSize);
+    }
+
+    TTF_Font *Painter::openFont(Font fontName, int fontSize) {
+        const char *path = fontPath(fontName);
+        if (!path) return nullptr;
+        if (const AssetPack *pack = AssetPack::mounted()) {
+            const std::string_view name = std::string_view(path).substr(2);
+            if (const auto asset = pack->find(name)) {
+                TTF_Font *font;
+                {
+                    std::lock_guard<std::mutex> lock(fontMutex);
+                    font = pack->openFont(name, fontSize);
+                }
+                GlyphCache::attach(font, asset.hash, fontSize);
+                return font;
+            }
+        }
+        TTF_Font *font;
+        {
+            std::lock_guard<std::mutex> lock(fontMutex);
+            font = TTF_OpenFont(path, fontSize);
         }
+        GlyphCache::attach(font, path, fontSize);
+        return font;
     }
 
-    void Graphics::drawString(int x, int y, std::string_view text, TTF_Font *font, Color color) {
+    void Painter::closeFont(TTF_Font *font) {
         if (!font) return;
-        SDL_Surface *surface = TTF_RenderText_Solid(font, text.data(), sdlc(color));
+        GlyphCache::detach(font);
+        std::lock_guard<std::mutex> lock(fontMutex);
+        TTF_CloseFont(font);
+        Graphics::fontClosed(font);
+    }
+
+    SDL_Surface *Painter::renderText(TTF_Font *font, std::string_view text, Color color, bool &owned) {
+        owned = true;
+        if (SDL_Surface *surface = GlyphCache::loadText(font, text, color & 0xFFFFFF))
+            return surface;
+        SDL_Surface *surface = renderRuns(font, text, sdlc(color));
+        GlyphCache::storeText(font, text, surface);
+        return surface;
+    }
+
+    TTF_Font *Painter::sizedFont(Font fontName, int fontSize, bool &owned) {
+        owned = true;
+        return getFont(fontName, fontSize);
+    }
+
+    void Painter::drawString(int x, int y, std::string_view text, int fontSize, Font fontName, Color color) {
+        bool ownedFont;
+        TTF_Font *font = sizedFont(fontName, fontSize, ownedFont);
+        if (!font) return;
+        drawString(x, y, text, font, color);
+        if (ownedFont)
+            closeFont(font);
+    }
+
+    void Painter::drawString(int x, int y, std::string_view text, TTF_Font *font, Color color) {
+        if (!font) return;
+        bool owned;
+        SDL_Surface *surface = renderText(font, text, color, owned);
         if (!surface) return;
         SDL_Rect textRect{ x,y };
-        SDL_BlitSurface(surface, NULL, screen, &textRect);
-        SDL_FreeSurface(surface);
+        SDL_BlitSurface(surface, NULL, target, &textRect);
+        if (owned)
+            SDL_FreeSurface(surface);
+    }
+
+    void Painter::drawString(float x, float y, std::string_view text, SdfFont &font, float px, Color color) {
+        font.draw(*this, x, y, text, px, color);
     }
 
-    void Graphics::drawString(SDL_Rect rect, std::string_view text, TTF_Font *font, Color color,
+    void Painter::drawString(SDL_Rect rect, std::string_view text, TTF_Font *font, Color color,
         bool hCenter, bool vCenter) {
-        if (!font) return;
-        SDL_Surface *surface = TTF_RenderText_Solid(font, text.data(), sdlc(color));
+        if (!font || !SDL_HasIntersection(&rect, &target->clip_rect)) return;
+        bool owned;
+        SDL_Surface *surface = renderText(font, text, color, owned);
         if (!surface) return;
         SDL_Rect textRect{
             rect.x + hCenter * (rect.w - surface->w) / 2,
             rect.y + vCenter * (rect.h - surface->h) / 2
         };
-        SDL_BlitSurface(surface, NULL, screen, &textRect);
-        SDL_FreeSurface(surface);
+        SDL_BlitSurface(surface, NULL, target, &textRect);
+        if (owned)
+            SDL_FreeSurface(surface);
     }
 
-    Window::Window(int width, int height, std::string_view title, Font fontName, int fontSize) :
-        w(width), h(height), title(title), state(State::RUN),
-        g(w, h), winfont(g.getFont(fontName, fontSize)) 
-    {
-        if (!g.isValid()) {
-            state = State::EXIT;
-            return;
-        }
-        SDL_SetWindowTitle(g.window, title.data());
-    }
+    Uint32 Window::taskEvent = (Uint32)-1;
 
-    Component *Window::addComponent(std::unique_ptr<Component> &&comp, std::string_view id) {
-        comp->mapColors(g);
-        comp->setWindow(this);
-        components[id] = std::move(comp);
+    SDL_Surface *Graphics::renderText(TTF_Font *font, std::string_view text, Color color, bool &owned) {
+        owned = false;
+        if (fontsClosed.load(std::memory_order_acquire))
+            forgetClosedFonts();
+        Uint64 hash = 0xCBF29CE484222325ull;
+        for (const auto word : { (Uint64)(std::uintptr_t)font, (Uint64)color })
+            hash = (hash ^ word) * 0x100000001B3ull;
+        for (const char c : text)
+            hash = (hash ^ (Uint8)c) * 0x100000001B3ull;
 
-        return components[id].get();
+        if (auto it = textIndex.find(hash); it != textIndex.end()) {
+            const auto entry = it->second;
+            if (entry->font == font && entry->color == color && entry->text == text) {
+                texts.splice(texts.begin(), texts, entry);
+                return entry->surface;
+            }
+            // hash collision, the newer string takes the slot
+            SDL_FreeSurface(entry->surface);
+            texts.erase(entry);
+            textIndex.erase(it);
+        }
+
+        bool rendered;
+        SDL_Surface *surface = Painter::renderText(font, text, color, rendered);
+        if (!surface) return nullptr;
+        texts.push_front({ font, color, std::string(text), hash, surface });
+        textIndex[hash] = texts.begin();
+        if (texts.size() > textCacheSize) {
+            SDL_FreeSurface(texts.back().surface);
+            textIndex.erase(texts.back().hash);
+            texts.pop_back();
+        }
+        return surface;
     }
 
-    void Window::draw() {
-        g.clear();
-        for (const auto &[_, comp] : components)
-            comp->draw(g);
+    // opened once per Graphics, so text drawn by name hits the text cache and
+    // windows on other threads never wait on each other's font opens
+    TTF_Font *Graphics::sizedFont(Font fontName, int fontSize, bool &owned) {
+        owned = false;
+        auto [it, fresh] = sizedFonts.try_emplace({ fontName, fontSize }, nullptr);
+        if (fresh)
+            it->second = getFont(fontName, fontSize);
+        return it->second;
     }
-    
-    void Window::update() {
-        SDL_UpdateTexture(g.scrtex, NULL, g.screen->pixels, g.screen->pitch);
-        SDL_RenderCopy(g.renderer, g.scrtex, NULL, NULL);
-        SDL_RenderPresent(g.renderer);
-        pendingUpdate = false;
+
+    void Graphics::forgetFont(TTF_Font *font) {
+        for (auto it = texts.begin(); it != texts.end();) {
+            if (it->font != font) {
+                ++it;
+                continue;
+            }
+            SDL_FreeSurface(it->surface);
+            textIndex.erase(it->hash);
+            it = texts.erase(it);
+        }
+        for (auto it = glyphs.begin(); it != glyphs.end();) {
+            if (it->first.font != font) {
+                ++it;
+                continue;
+            }
+            SDL_FreeSurface(it->second);
+            it = glyphs.erase(it);
+        }
     }
 
-    bool Window::handleEvent(const SDL_Event &event) {
-        if (event.type == SDL_QUIT) {
-            state = State::EXIT;
-            return true;
+    // font mutex held
+    void Graphics::fontClosed(TTF_Font *font) {
+        for (Graphics *g : instances) {
+            g->closedFonts.push_back(font);
+            g->fontsClosed.store(true, std::memory_order_release);
         }
-        else if (event.type != SDL_KEYUP)
-            return false;
+    }
 
-        switch (event.key.keysym.sym) {
-        case SDLK_ESCAPE:
-            state = State::EXIT;
-            return true;
-        default:
-            return false;
+    void Graphics::forgetClosedFonts() {
+        std::vector<TTF_Font *> closed;
+        {
+            std::lock_guard<std::mutex> lock(fontMutex);
+            closed.swap(closedFonts);
+            fontsClosed = false;
         }
+        for (TTF_Font *font : closed)
+            forgetFont(font);
     }
 
-    void Window::events() {
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            if (this->handleEvent(event))
-                continue;
-            for (const auto &[_, comp] : components) {
-                if (auto status = comp->handleEvent(event)) {
-                    pendingUpdate = true;
-                    if (status == Component::EventStatus::HANDLED)
-                        break;
-                }
-            }
+    SDL_Surface *Graphics::glyph(TTF_Font *font, Uint16 ch, Color color) {
+        if (fontsClosed.load(std::memory_order_acquire))
+            forgetClosedFonts();
+        const GlyphKey key{ font, ch, color };
+        if (auto it = glyphs.find(key); it != glyphs.end())
+            return it->second;
+        SDL_Surface *surface = Preloader::takeGlyph(font, ch, color & 0xFFFFFF);
+        if (!surface)
+            surface = GlyphCache::load(font, ch, color & 0xFFFFFF);
+        if (!surface && font) {
+            surface = TTF_RenderGlyph_Solid(font, ch, sdlc(color));
+            GlyphCache::store(font, ch, surface);
         }
+        return glyphs[key] = surface;
     }
 
-    void Window::run() {
-        while (state == State::RUN) {
-            SDL_Delay(5);
-            events();
-            if (pendingUpdate) {
-                draw();
-                update();
+    MappedFile::MappedFile(const std::string &path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER fileSize{};
+        HANDLE mapping = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0
+            ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+        CloseHandle(file);
+        if (!mapping) return;
+        // the view keeps the mapping alive
+        ptr = (const Uint8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (ptr) len = (std::size_t)fileSize.QuadPart;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *view = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                ptr = (const Uint8 *)view;
+                len = (std::size_t)st.st_size;
             }
         }
+        ::close(fd);
+#endif
     }
 
-    void Component::mapColors(const Graphics &g) {
-        int index = 0;
-        auto cols = colors.ptrs();
-        for (auto raw : rawColors.ptrs())
-            *cols[index++] = g.color(*raw);
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            this->~MappedFile();
+            ptr = std::exchange(other.ptr, nullptr);
+            len = std::exchange(other.len, 0);
+        }
+        return *this;
     }
 
-    bool Component::handleHoverHL(const SDL_Event &event) {
-        if (event.type == SDL_MOUSEMOTION 
-            && posInside({ event.button.x, event.button.y }) != hovered) {
-            hovered ^= true;
-            return true;
-        }
-        return false;
+    MappedFile::~MappedFile() {
+        if (!ptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(ptr);
+#else
+        munmap((void *)ptr, len);
+#endif
+        ptr = nullptr;
+        len = 0;
     }
 
-    int Component::thisWasClicked(const SDL_Event &event) const {
-        if (event.type == SDL_MOUSEBUTTONDOWN 
-            && posInside({ event.button.x, event.button.y }))
-            return event.button.clicks;
-        return 0;
+    std::mutex GlyphCache::mtx{};
+    std::string GlyphCache::dir{};
+    std::unordered_map<std::string, std::unique_ptr<GlyphCache::Archive>> GlyphCache::archives{};
+    std::unordered_map<TTF_Font *, GlyphCache::Archive *> GlyphCache::fonts{};
+    std::unordered_map<std::string, Uint64> GlyphCache::fileHashes{};
+
+    void GlyphCache::setDirectory(std::string path) {
+        std::lock_guard<std::mutex> lock(mtx);
+        dir = std::move(path);
     }
 
-    int Component::clickOutside(const SDL_Event &event) const {
-        if (event.type == SDL_MOUSEBUTTONDOWN
-            && !posInside({ event.button.x, event.button.y }))
-            return event.button.clicks;
-        return 0;
+    static Uint64 fnv1a(const Uint8 *data, std::size_t size) {
+        Uint64 hash = 0xCBF29CE484222325ull;
+        for (std::size_t i = 0; i < size; ++i)
+            hash = (hash ^ data[i]) * 0x100000001B3ull;
+        return hash;
     }
 
-    Component::EventStatus Panel::handleEvent(const SDL_Event &event) {
-        if (!shown) return EventStatus::IGNORED;
-        return multihandleEvent(event, comps);
-        //for (const auto &comp : comps)
-        //    if (auto status = comp->handleEvent(event))
-        //        return EventStatus::HANDLED;
-        //return EventStatus::IGNORED;
+    Uint64 GlyphCache::hashFile(const std::string &path) {
+        const MappedFile file(path);
+        return file.isOpen() ? fnv1a(file.data(), file.size()) : 0;
     }
 
-    void Panel::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, colors.bg, colors.line);
-        for (const auto &comp : comps)
-            comp->draw(g);
+    void GlyphCache::attach(TTF_Font *font, const char *fontFile, int size) {
+        if (!font || !fontFile) return;
+        Uint64 fileHash = 0;
+        bool known;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (dir.empty()) return;
+            auto it = fileHashes.find(fontFile);
+            known = it != fileHashes.end();
+            if (known) fileHash = it->second;
+        }
+        if (!known) {
+            // hashed unlocked so drawing on other threads goes on; two threads
+            // hashing the same file just store the same value
+            fileHash = hashFile(fontFile);
+            std::lock_guard<std::mutex> lock(mtx);
+            fileHashes.emplace(fontFile, fileHash);
+        }
+        attach(font, fileHash, size);
     }
 
-    void Panel::setWindow(Window *window) {
-        Component::setWindow(window);
-        for (const auto &comp : comps) {
-            comp->setWindow(win);
-            comp->mapColors(win->graphics());
+    void GlyphCache::attach(TTF_Font *font, Uint64 fileHash, int size) {
+        if (!font || !fileHash) return;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (dir.empty()) return;
+
+        char name[64];
+        std::snprintf(name, sizeof name, "%016llx_%d_%d.glyphs",
+            (unsigned long long)fileHash, size, TTF_GetFontStyle(font));
+        const std::string file = (std::filesystem::u8path(dir) / name).u8string();
+        auto &archive = archives[file];
+        if (!archive) {
+            archive = std::make_unique<Archive>();
+            archive->file = file;
+            mapArchive(*archive);
         }
+        fonts[font] = archive.get();
     }
 
-    void Panel::translate(int x, int y) {
-        Component::translate(x, y);
-        for (auto &comp : comps)
-            comp->translate(x, y);
+    void GlyphCache::detach(TTF_Font *font) {
+        std::lock_guard<std::mutex> lock(mtx);
+        fonts.erase(font);
     }
-    
-    Component *Panel::addComponent(std::unique_ptr<Component> &&comp) {
-        if (win) {
-            comp->setWindow(win);
-            comp->mapColors(win->graphics());
+
+    Uint64 GlyphCache::textKey(std::string_view text) {
+        return fnv1a((const Uint8 *)text.data(), text.size()) | 1ull << 63;
+    }
+
+    // header: magic, count, reserved; then count entries, then the bitmaps
+    void GlyphCache::mapArchive(Archive &archive) {
+        constexpr std::size_t headerSize = sizeof(magic) + 8;
+        archive.index.clear();
+        archive.runs = 0;
+        archive.map = MappedFile(archive.file);
+        const Uint8 *base = archive.map.data();
+        const std::size_t size = archive.map.size();
+        if (size < headerSize || std::memcmp(base, magic, sizeof(magic)) != 0) return;
+
+        Uint32 count;
+        std::memcpy(&count, base + sizeof(magic), sizeof(count));
+        if ((size - headerSize) / sizeof(Entry) < count) return;
+        for (Uint32 i = 0; i < count; ++i) {
+            Entry entry;
+            std::memcpy(&entry, base + headerSize + i * sizeof(Entry), sizeof(Entry));
+            const std::size_t bytes = 1ull * entry.pitch * entry.h + entry.textLen;
+            if (entry.pitch < entry.w || entry.offset > size || bytes > size - entry.offset)
+                continue;
+            archive.index[entry.key] = entry;
+            archive.runs += entry.key >> 63;
         }
-        comps.push_back(std::move(comp));
+    }
 
-        return comps.back().get();
+    SDL_Surface *GlyphCache::load(TTF_Font *font, Uint16 ch, int rgb) {
+        return load(font, ch, {}, rgb);
     }
 
-    void ScrollPanel::translate(int x, int y) {
-        Panel::translate(x, y);
-        scrollBegin.x += x;
-        scrollBegin.y += y;
+    SDL_Surface *GlyphCache::loadText(TTF_Font *font, std::string_view text, int rgb) {
+        return load(font, textKey(text), text, rgb);
     }
 
-    Component::EventStatus ScrollPanel::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        if (Panel::handleEvent(event)) return HANDLED;
-        if (event.type != SDL_MOUSEWHEEL) return IGNORED;
+    void GlyphCache::store(TTF_Font *font, Uint16 ch, const SDL_Surface *glyph) {
+        store(font, ch, {}, glyph);
+    }
 
-        int offset = sgn(event.wheel.y);
-        if (index + offset >= 0 && index + offset + numShown <= (int)comps.size()) {
-            index += offset;
-            scrollContent();
+    void GlyphCache::storeText(TTF_Font *font, std::string_view text, const SDL_Surface *run) {
+        store(font, textKey(text), text, run);
+    }
+
+    SDL_Surface *GlyphCache::load(TTF_Font *font, Uint64 key, std::string_view text, int rgb) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto found = fonts.find(font);
+        if (found == fonts.end()) return nullptr;
+        const Archive &archive = *found->second;
+
+        const Uint8 *src;
+        int w, h, pitch;
+        if (auto it = archive.index.find(key); it != archive.index.end()) {
+            const Entry &entry = it->second;
+            src = archive.map.data() + entry.offset;
+            w = entry.w, h = entry.h, pitch = entry.pitch;
+            const char *stored = (const char *)src + 1LL * pitch * h;
+            if (std::string_view(stored, entry.textLen) != text) return nullptr;
         }
-        return HANDLED;
+        else if (auto p = archive.pending.find(key); p != archive.pending.end()) {
+            if (p->second.text != text) return nullptr;
+            src = p->second.pixels.data();
+            w = pitch = p->second.w, h = p->second.h;
+        }
+        else return nullptr;
+
+        // copied out, so the archive can be rewritten while glyphs are in use
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 8, SDL_PIXELFORMAT_INDEX8);
+        if (!surface) return nullptr;
+        for (int y = 0; y < h; ++y)
+            std::memcpy((Uint8 *)surface->pixels + 1LL * y * surface->pitch, src + 1LL * y * pitch, w);
+        const Uint8 r = (Uint8)(rgb >> 16), g = (Uint8)(rgb >> 8), b = (Uint8)rgb;
+        const SDL_Color palette[2] = { { (Uint8)~r, (Uint8)~g, (Uint8)~b, 0 }, { r, g, b, 255 } };
+        SDL_SetPaletteColors(surface->format->palette, palette, 0, 2);
+        SDL_SetColorKey(surface, SDL_TRUE, 0);
+        return surface;
     }
 
-    Component *ScrollPanel::addComponent(std::unique_ptr<Component> &&comp) {
-        auto ret = Panel::addComponent(std::move(comp));
-        scrollContent();
-        return ret;
+    void GlyphCache::store(TTF_Font *font, Uint64 key, std::string_view text, const SDL_Surface *bitmap) {
+        if (!bitmap || bitmap->format->BytesPerPixel != 1) return;
+        if (bitmap->w > 0xFFFF || bitmap->h > 0xFFFF || text.size() > 0xFFFF) return;
+        std::lock_guard<std::mutex> lock(mtx);
+        auto found = fonts.find(font);
+        if (found == fonts.end()) return;
+        Archive &archive = *found->second;
+        // a colliding run keeps the slot it has
+        if (archive.index.count(key) || archive.pending.count(key)) return;
+        if (!text.empty() && archive.runs >= maxRuns) return;
+
+        Pending bits{ (Uint16)bitmap->w, (Uint16)bitmap->h, {}, std::string(text) };
+        bits.pixels.resize(1ull * bitmap->w * bitmap->h);
+        for (int y = 0; y < bitmap->h; ++y)
+            std::memcpy(bits.pixels.data() + 1LL * y * bitmap->w,
+                (const Uint8 *)bitmap->pixels + 1LL * y * bitmap->pitch, bitmap->w);
+        archive.pending.emplace(key, std::move(bits));
+        archive.runs += !text.empty();
     }
 
-    void ScrollPanel::scrollContent() {
-        int yoff = 0;
-        for (std::size_t i = 0; i < comps.size(); ++i) {
-            auto &cur = *comps[i];
-            if (i >= index && i < 0ULL + index + numShown) {
-                cur.show();
-                cur.setPos(scrollBegin.x, scrollBegin.y + yoff);
-                yoff += cur.h();
+    void GlyphCache::flush() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &[_, archive] : archives) {
+            if (archive->pending.empty()) continue;
+            auto glyphs = std::move(archive->pending);
+            archive->pending.clear();
+            for (const auto &[key, entry] : archive->index) {
+                if (glyphs.count(key)) continue;
+                const Uint8 *src = archive->map.data() + entry.offset;
+                Pending old{ entry.w, entry.h, {},
+                    std::string((const char *)src + 1LL * entry.pitch * entry.h, entry.textLen) };
+                old.pixels.resize(1ull * entry.w * entry.h);
+                for (int y = 0; y < entry.h; ++y)
+                    std::memcpy(old.pixels.data() + 1LL * y * entry.w, src + 1LL * y * entry.pitch, entry.w);
+                glyphs.emplace(key, std::move(old));
             }
-            else {
-                cur.hide();
+
+            const Uint32 count = (Uint32)glyphs.size(), reserved = 0;
+            std::vector<Uint8> out(sizeof(magic) + 8 + count * sizeof(Entry));
+            std::memcpy(out.data(), magic, sizeof(magic));
+            std::memcpy(out.data() + sizeof(magic), &count, sizeof(count));
+            std::memcpy(out.data() + sizeof(magic) + 4, &reserved, sizeof(reserved));
+            std::size_t at = sizeof(magic) + 8;
+            for (const auto &[key, bits] : glyphs) {
+                const Entry entry{ key, (Uint32)out.size(), bits.w, bits.h, bits.w, (Uint16)bits.text.size(), 0 };
+                std::memcpy(out.data() + at, &entry, sizeof(entry));
+                at += sizeof(entry);
+                out.insert(out.end(), bits.pixels.begin(), bits.pixels.end());
+                out.insert(out.end(), bits.text.begin(), bits.text.end());
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::u8path(dir), ec);
+            const std::string tmp = archive->file + ".tmp";
+            std::FILE *f = std::fopen(tmp.c_str(), "wb");
+            if (!f) {
+                error("GlyphCache::flush", tmp.c_str());
+                continue;
+            }
+            const bool written = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+            std::fclose(f);
+            // unmapped first, a mapped file cannot be replaced on Windows
+            archive->map = MappedFile();
+            if (written)
+                std::filesystem::rename(std::filesystem::u8path(tmp), std::filesystem::u8path(archive->file), ec);
+            if (!written || ec) {
+                error("GlyphCache::flush", archive->file.c_str());
+                std::filesystem::remove(std::filesystem::u8path(tmp), ec);
             }
+            mapArchive(*archive);
         }
     }
 
-    Component::EventStatus Button::handleEvent(const SDL_Event &event) {
-        if (!shown || !callback) return IGNORED;
-        if (handleHoverHL(event)) return HANDLED;
-        if (thisWasClicked(event)) {
-            callback(this);
-            return HANDLED;
+    const AssetPack *AssetPack::mountedPack = nullptr;
+
+    AssetPack::AssetPack(const std::string &path) : map(path) {
+        if (!map.isOpen()) {
+            error("AssetPack", path.c_str());
+            return;
+        }
+        const std::size_t size = map.size();
+        Uint32 n = 0;
+        bool valid = size >= headerSize && std::memcmp(map.data(), magic, sizeof(magic)) == 0;
+        if (valid) {
+            std::memcpy(&n, map.data() + sizeof(magic), sizeof(n));
+            valid = (size - headerSize) / sizeof(Entry) >= n;
+        }
+        count = valid ? n : 0;
+        // checked once, so lookups can trust the index
+        for (Uint32 i = 0; valid && i < count; ++i) {
+            const Entry e = entry(i);
+            valid = e.nameOffset <= size && e.nameLen <= size - e.nameOffset
+                && e.offset <= size && e.size <= size - e.offset
+                && (i == 0 || name(i - 1) < name(i));
+        }
+        if (!valid) {
+            error("AssetPack", ("corrupt pack " + path).c_str());
+            map = MappedFile();
+            count = 0;
         }
-        return IGNORED;
     }
 
-    void Button::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
-        g.drawString(rect, text, win->font(), colors.text);
+    AssetPack::Entry AssetPack::entry(std::size_t index) const {
+        Entry e;
+        std::memcpy(&e, map.data() + headerSize + index * sizeof(Entry), sizeof(Entry));
+        return e;
     }
 
-    Expandable::Expandable(SDL_Rect rect, std::string_view text, const CompColors &colors,
-        std::unique_ptr<Panel> &&panel, ExpandDir expDir) :
-        Component(rect, colors), text(text), panel(std::move(panel)) {
-        if (win) {
-            this->panel->setWindow(win);
-            this->panel->mapColors(win->graphics());
+    std::string_view AssetPack::name(std::size_t index) const {
+        const Entry e = entry(index);
+        return { (const char *)map.data() + e.nameOffset, e.nameLen };
+    }
+
+    AssetPack::Asset AssetPack::find(std::string_view assetName) const {
+        std::size_t lo = 0, hi = count;
+        while (lo < hi) {
+            const std::size_t mid = (lo + hi) / 2;
+            const std::string_view midName = name(mid);
+            if (midName == assetName) {
+                const Entry e = entry(mid);
+                return { map.data() + e.offset, (std::size_t)e.size, e.hash };
+            }
+            if (midName < assetName) lo = mid + 1;
+            else hi = mid;
         }
-        this->panel->hide();
-        setExpandDir(expDir);
+        return {};
     }
 
-    void Expandable::setExpandDir(ExpandDir dir) {
-        switch (dir) {
-        case ExpandDir::UP:
-            expOffset = { 0, -panel->h() };
-            break;
-        case ExpandDir::DOWN:
-            expOffset = { 0, h() };
-            break;
-        case ExpandDir::LEFT_UP:
-            expOffset = { -panel->w(), -(panel->h() - h()) };
-            break;
-        case ExpandDir::RIGHT_UP:
-            expOffset = { w(), -(panel->h() - h()) };
-            break;
-        case ExpandDir::LEFT_DOWN:
-            expOffset = { -panel->w(), 0 };
-            break;
-        case ExpandDir::RIGHT_DOWN:
-            expOffset = { w(), 0 };
-            break;
-        default:
-            break;
-        }
-        adjustPanel();
+    SDL_RWops *AssetPack::open(std::string_view assetName) const {
+        const Asset asset = find(assetName);
+        return asset ? SDL_RWFromConstMem(asset.data, (int)asset.size) : nullptr;
     }
 
-    void Expandable::setWindow(Window *window) {
-        Component::setWindow(window);
-        panel->setWindow(window);
-        panel->mapColors(win->graphics());
+    TTF_Font *AssetPack::openFont(std::string_view assetName, int size) const {
+        SDL_RWops *rw = open(assetName);
+        return rw ? TTF_OpenFontRW(rw, 1, size) : nullptr;
     }
 
-    Component::EventStatus Expandable::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        if (handleHoverHL(event)) return HANDLED;
-        if (panel->handleEvent(event)) return HANDLED;
-        if (thisWasClicked(event) == 1) {
-            toggleExpanded();
-            return FORWARDED;
+    SDL_Surface *AssetPack::loadImage(std::string_view assetName) const {
+        SDL_RWops *rw = open(assetName);
+        SDL_Surface *loaded = rw ? SDL_LoadBMP_RW(rw, 1) : nullptr;
+        if (!loaded) return nullptr;
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        return converted;
+    }
+
+    // header: magic, count, reserved; sorted entries; names; data aligned to 16
+    bool AssetPack::build(const std::string &packPath,
+        const std::vector<std::pair<std::string, std::string>> &files) {
+        std::vector<std::pair<std::string, MappedFile>> sources;
+        for (const auto &[assetName, source] : files) {
+            MappedFile file(source);
+            // empty files cannot be mapped and are stored empty
+            if (!file.isOpen() && !std::filesystem::exists(std::filesystem::u8path(source)))
+                return error("AssetPack::build", source.c_str());
+            sources.emplace_back(assetName, std::move(file));
         }
-        if (event.type == SDL_MOUSEBUTTONDOWN
-            && expanded
-            && !panel->posInside({ event.button.x, event.button.y })) {
-            setExpanded(false);
-            return FORWARDED;
+        std::sort(sources.begin(), sources.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (std::size_t i = 1; i < sources.size(); ++i)
+            if (sources[i - 1].first == sources[i].first)
+                return error("AssetPack::build", ("duplicate name " + sources[i].first).c_str());
+
+        const Uint32 n = (Uint32)sources.size(), reserved = 0;
+        std::vector<Uint8> out(headerSize + n * sizeof(Entry));
+        std::memcpy(out.data(), magic, sizeof(magic));
+        std::memcpy(out.data() + sizeof(magic), &n, sizeof(n));
+        std::memcpy(out.data() + sizeof(magic) + 4, &reserved, sizeof(reserved));
+
+        std::vector<Entry> entries(n);
+        for (Uint32 i = 0; i < n; ++i) {
+            const std::string &assetName = sources[i].first;
+            entries[i].nameOffset = (Uint32)out.size();
+            entries[i].nameLen = (Uint32)assetName.size();
+            out.insert(out.end(), assetName.begin(), assetName.end());
         }
-        return IGNORED;
+        for (Uint32 i = 0; i < n; ++i) {
+            const MappedFile &file = sources[i].second;
+            out.resize((out.size() + dataAlign - 1) / dataAlign * dataAlign);
+            entries[i].offset = out.size();
+            entries[i].size = file.size();
+            entries[i].hash = fnv1a(file.data(), file.size());
+            if (file.isOpen())
+                out.insert(out.end(), file.data(), file.data() + file.size());
+        }
+        std::memcpy(out.data() + headerSize, entries.data(), n * sizeof(Entry));
+
+        std::FILE *f = std::fopen(packPath.c_str(), "wb");
+        if (!f)
+            return error("AssetPack::build", packPath.c_str());
+        const bool written = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+        return (std::fclose(f) == 0 && written) || error("AssetPack::build", packPath.c_str());
     }
 
-    void Expandable::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
-        g.drawString(rect, text, win->font(), colors.text);
-        panel->draw(g);
+    Preloader *Preloader::active = nullptr;
+
+    Preloader::Preloader(std::vector<FontSpec> fontSpecs, std::vector<std::string> imagePaths) :
+        started(SDL_GetPerformanceCounter()) {
+        for (auto &spec : fontSpecs)
+            fonts.push_back({ std::move(spec) });
+        for (auto &path : imagePaths)
+            images.push_back({ std::move(path) });
+        // on this thread, so Graphics finds TTF already initialized
+        if (!TTF_WasInit() && TTF_Init() != 0)
+            error("TTF_Init", TTF_GetError());
+        active = this;
+        worker = std::thread(&Preloader::run, this);
     }
 
-    void Expandable::translate(int x, int y) {
-        Component::translate(x, y);
-        panel->translate(x, y);
+    Preloader::~Preloader() {
+        cancel = true;
+        if (worker.joinable())
+            worker.join();
+        if (active == this)
+            active = nullptr;
+        for (auto &font : fonts)
+            if (!font.taken && font.ttf)
+                Painter::closeFont(font.ttf);
+        for (auto &image : images)
+            if (!image.taken && image.surface)
+                SDL_FreeSurface(image.surface);
+        for (auto &[_, surface] : glyphs)
+            SDL_FreeSurface(surface);
     }
 
-    Component::EventStatus ComboBox::Elem::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        if (handleHoverHL(event)) return HANDLED;
-        if (thisWasClicked(event)) {
-            comboBox->setSelection(ind);
-            comboBox->setExpanded(false);
-            return HANDLED;
+    // fonts first, in the order given, since the first frame needs them
+    void Preloader::run() {
+        for (auto &font : fonts) {
+            TTF_Font *ttf = nullptr;
+            std::map<GlyphKey, SDL_Surface *> rendered;
+            if (!cancel)
+                ttf = Painter::openFont(font.spec.font, font.spec.size);
+            if (ttf) {
+                for (int rgb : font.spec.colors) {
+                    const SDL_Color color{ (Uint8)(rgb >> 16), (Uint8)(rgb >> 8), (Uint8)rgb, 255 };
+                    for (Uint16 ch : font.spec.glyphs) {
+                        if (rendered.count({ ttf, ch, rgb })) continue;
+                        SDL_Surface *surface = GlyphCache::load(ttf, ch, rgb);
+                        if (!surface) {
+                            surface = TTF_RenderGlyph_Solid(ttf, ch, color);
+                            GlyphCache::store(ttf, ch, surface);
+                        }
+                        rendered[{ ttf, ch, rgb }] = surface;
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                font.ttf = ttf;
+                font.ready = true;
+                glyphs.merge(rendered);
+            }
+            cv.notify_all();
         }
-        return IGNORED;
+        for (auto &image : images) {
+            SDL_Surface *surface = nullptr;
+            if (!cancel) {
+                // the mounted pack first, as Painter::openFont does for fonts
+                std::string_view name = image.path;
+                if (name.substr(0, 2) == "./")
+                    name.remove_prefix(2);
+                const AssetPack *pack = AssetPack::mounted();
+                if (pack && pack->find(name))
+                    surface = pack->loadImage(name);
+                else if (SDL_Surface *loaded = SDL_LoadBMP(image.path.c_str())) {
+                    surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+                    SDL_FreeSurface(loaded);
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                image.surface = surface;
+                image.ready = true;
+            }
+            cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+        cv.notify_all();
     }
 
-    void ComboBox::Elem::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
-        g.drawString(rect, text, win->font(), colors.text);
+    Uint64 Preloader::startTicks() {
+        return active ? active->started : 0;
     }
 
-    std::unique_ptr<ScrollPanel> ComboBox::makePanel(int numShown) {
-        const SDL_Rect panelRect{ 0, 0, w(), h() * numShown };
-        return std::make_unique<ScrollPanel>(panelRect, rawColors.bg,
-            rawColors.line, numShown);
+    TTF_Font *Preloader::takeFont(Font font, int size) {
+        if (!active) return nullptr;
+        Preloader &pre = *active;
+        std::unique_lock<std::mutex> lock(pre.mtx);
+        for (auto &loaded : pre.fonts) {
+            if (loaded.taken || loaded.spec.font != font || loaded.spec.size != size)
+                continue;
+            pre.cv.wait(lock, [&] { return loaded.ready; });
+            loaded.taken = true;
+            return loaded.ttf;
+        }
+        // not preloaded: the caller opens it itself, fontMutex keeps that safe
+        // alongside the worker
+        return nullptr;
     }
 
-    void ComboBox::setWindow(Window *window) {
-        Expandable::setWindow(window);
-        if (!wasInit)
-            finalizePanel();
+    SDL_Surface *Preloader::takeImage(std::string_view path) {
+        if (!active) return nullptr;
+        Preloader &pre = *active;
+        std::unique_lock<std::mutex> lock(pre.mtx);
+        for (auto &image : pre.images) {
+            if (image.taken || image.path != path)
+                continue;
+            pre.cv.wait(lock, [&] { return image.ready; });
+            image.taken = true;
+            return image.surface;
+        }
+        return nullptr;
     }
 
-    void ComboBox::finalizePanel() {
-        for (int i = 0; i < (int)options.size(); ++i)
-            panel->addComponent(std::make_unique<Elem>(rect, rawColors, i, options[i], this));
-        panel->rawColors = rawColors;
-        panel->setWindow(win);
-        wasInit = true;
+    SDL_Surface *Preloader::takeGlyph(TTF_Font *font, Uint16 ch, int rgb) {
+        if (!active) return nullptr;
+        std::lock_guard<std::mutex> lock(active->mtx);
+        auto it = active->glyphs.find({ font, ch, rgb });
+        if (it == active->glyphs.end()) return nullptr;
+        SDL_Surface *surface = it->second;
+        active->glyphs.erase(it);
+        return surface;
     }
 
-    void Slider::translate(int x, int y) {
-        Component::translate(x, y);
-        sliderRect.x += x;
-        sliderRect.y += y;
+    void ContextMenu::clear() {
+        items.clear();
+        hovered = -1;
+        open = false;
     }
 
-    Component::EventStatus Slider::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        const SDL_Point p = { event.button.x, event.button.y };
-        const bool inRect = SDL_PointInRect(&p, &sliderRect);
+    void ContextMenu::show(SDL_Point pos, const SDL_Rect &bounds, TTF_Font *font) {
+        int width = minW;
+        for (const auto &item : items) {
+            int tw = 0, th = 0;
+            measureRuns(font, item.label, tw, th);
+            width = std::max(width, tw + 2 * padX);
+        }
+        rect = { pos.x, pos.y, width, (int)items.size() * itemH };
+        if (rect.x + rect.w > bounds.x + bounds.w)
+            rect.x = std::max(bounds.x, pos.x - rect.w);
+        if (rect.y + rect.h > bounds.y + bounds.h)
+            rect.y = std::max(bounds.y, pos.y - rect.h);
+        hovered = -1;
+        open = !items.empty();
+    }
+
+    bool ContextMenu::handleEvent(const SDL_Event &event) {
+        if (!open) return false;
         switch (event.type) {
-        case SDL_MOUSEMOTION:
-            if (hovered != inRect) {
-                hovered = inRect;
-                return HANDLED;
-            }
-            if (dragging) {
-                dragDiff(p - mousePos);
-                checkCallback();
-                mousePos = p;
-                return HANDLED;
-            }
-            break;
-        case SDL_MOUSEBUTTONDOWN:
-            if (inRect) {
-                mousePos = p;
-                dragging = true;
-                return HANDLED;
+        case SDL_MOUSEMOTION: {
+            const SDL_Point pos{ event.motion.x, event.motion.y };
+            const bool inside = SDL_PointInRect(&pos, &rect);
+            hovered = inside ? (pos.y - rect.y) / itemH : -1;
+            return inside;
+        }
+        case SDL_MOUSEBUTTONDOWN: {
+            const SDL_Point pos{ event.button.x, event.button.y };
+            open = false;
+            if (SDL_PointInRect(&pos, &rect)) {
+                // the action may rebuild the menu
+                Action action = items[(pos.y - rect.y) / itemH].action;
+                if (action) action();
             }
-            break;
-        case SDL_MOUSEBUTTONUP:
-            dragging = false;
-            return FORWARDED;
+            return true;
+        }
+        case SDL_KEYUP:
+            if (event.key.keysym.sym != SDLK_ESCAPE) return false;
+            open = false;
+            return true;
         default:
-            break;
+            return false;
         }
-        return IGNORED;
     }
 
-    void Slider::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, colors.extra1, colors.line);
-        g.drawRect(sliderRect, 1,
-            (hovered || dragging) ? colors.hl : colors.bg, colors.line);
+    void ContextMenu::draw(Graphics &g, TTF_Font *font, int bgcolor, int textcolor, int hlcolor) const {
+        g.drawRect(rect, 1, g.color(bgcolor), g.color(hlcolor));
+        const Color text = g.color(textcolor);
+        for (int i = 0; i < (int)items.size(); ++i) {
+            const SDL_Rect row{ rect.x, rect.y + i * itemH, rect.w, itemH };
+            if (i == hovered)
+                SDL_FillRect(g.screen, &row, g.color(hlcolor));
+            g.drawString({ row.x + padX, row.y, row.w - 2 * padX, row.h }, items[i].label, font, text, false);
+        }
     }
 
-    SDL_Rect Slider::makeSliderRect(int w) const {
-        if (vertical) {
-            return { rect.x - w / 2, rect.y, rect.w + w, w };
+    Window::Window(int width, int height, std::string_view title, Font fontName, int fontSize, bool headless) :
+        w(width), h(height), title(title), state(State::RUN), headless(headless),
+        startTicks(Preloader::startTicks() ? Preloader::startTicks() : SDL_GetPerformanceCounter()),
+        g(w, h, headless), winfont(headless ? Painter::openFont(fontName, fontSize) : g.getFont(fontName, fontSize))
+    {
+        if (!g.isValid()) {
+            state = State::EXIT;
+            return;
         }
-        return { rect.x, rect.y - w / 2, w, rect.h + w };
+        if (headless) return;
+        if (taskEvent == (Uint32)-1)
+            taskEvent = SDL_RegisterEvents(1);
+        SDL_SetWindowTitle(g.window, title.data());
     }
 
-    void Slider::checkCallback() {
-        if (!onValChange) return;
-        const int nv = trueVal();
-        if (nv != lastVal) {
-            lastVal = nv;
-            onValChange(nv);
-        }
+    Window::~Window() {
+        Painter::closeFont(winfont);
     }
 
-    void Slider::dragDiff(SDL_Point dp) {
-        if (vertical) {
-            val += (dp.y * upp());
-            capVal();
-            sliderRect.y = rect.y + static_cast<int>(std::round(stepn() * pps()));
+    void Window::post(Task &&task) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            wake = !taskQueued;
+            taskQueued = true;
+            tasks.push_back(std::move(task));
         }
-        else {
-            val += (dp.x * upp());
-            capVal();
-            sliderRect.x = rect.x + static_cast<int>(std::round(stepn() * pps()));
+        // a headless window runs its tasks in renderFrame
+        if (wake && !headless) {
+            SDL_Event event{};
+            event.type = taskEvent;
+            // a full queue, so the next post tries again
+            if (SDL_PushEvent(&event) < 1) {
+                std::lock_guard<std::mutex> lock(taskMutex);
+                taskQueued = false;
+            }
         }
     }
 
-    void Slider::capVal() {
-        if (val > max)
-            val = float(max);
-        else if (val < min)
-            val = float(min);
+    void Window::runTasks() {
+        std::vector<Task> batch;
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            batch.swap(tasks);
+            taskQueued = false;
+        }
+        for (auto &task : batch)
+            task();
+        pendingUpdate = true;
     }
 
-    Color ColorSelect::color() const {
-        return
-            colSlider[0]->trueVal() << 16 | 
-            colSlider[1]->trueVal() << 8 | 
-            colSlider[2]->trueVal();
-    }
+    Component *Window::addComponent(std::unique_ptr<Component> &&comp, std::string_view id) {
+        comp->mapColors(g);
+        comp->setWindow(this);
+        components[id] = std::move(comp);
 
-    std::string ColorSelect::str() const {
-        return 
-            hex(colSlider[0]->trueVal()) +
-            hex(colSlider[1]->trueVal()) +
-            hex(colSlider[2]->trueVal());
+        return components[id].get();
     }
 
-    std::unique_ptr<Panel> ColorSelect::makePanel() const {
-        return std::make_unique<Panel>(SDL_Rect{ 0,0,350,140 }, 0, 0);
+    void Window::draw() {
+        g.clear();
+        for (const auto &[_, comp] : components)
+            if (comp.get() != modal)
+                comp->draw(g);
+        if (modal)
+            modal->draw(g);
+        drawOverlay();
     }
 
-    std::unique_ptr<TextInput> ColorSelect::makeInput() {
-        auto input = std::make_unique<TextInput>(
-            SDL_Rect{rect.x + rect.w, rect.y, rect.w, 30}, 
-            rawColors, "", true);
-        input->setCallback([csel = this](const std::string &val) {
-            csel->setColor(val);
-        });
-        return input;
+    void Window::drawOverlay() {
+        if (!tipText.empty()) {
+            g.drawRect(tipRect, 1, g.color(tooltipBg), g.color(tooltipText));
+            g.drawString(tipRect, tipText, winfont, g.color(tooltipText));
+        }
+        if (menu.isOpen())
+            menu.draw(g, winfont, menuBg, menuText, menuHL);
+    }
+    
+    void Window::update() {
+        SDL_UpdateTexture(g.scrtex, NULL, g.screen->pixels, g.screen->pitch);
+        SDL_RenderCopy(g.renderer, g.scrtex, NULL, NULL);
+        SDL_RenderPresent(g.renderer);
+        pendingUpdate = false;
+        damage = {};
+        if (firstFrameMs < 0)
+            firstFrameMs = elapsedMs(startTicks);
     }
 
-    void ColorSelect::finalize() {
-        CompColors cols = rawColors;
-        for (int i = 0; i < _countof(colSlider); ++i) {
-            SDL_Rect r{panel->x() + 70, panel->y() + 30 + 35 * i, 255, 13};
-            cols.bg = 0xFF0000 >> (8 * i);
-            colSlider[i] = panel->addComponent(
-                std::make_unique<Slider>(r, 0, 255, 1, cols, false, 13)
-            )->as<Slider>();
-        }
-        panel->rawColors = rawColors;
-        panel->setWindow(win);
-        panel->mapColors(win->graphics());
-        input->setWindow(win);
-        input->mapColors(win->graphics());
-        wasInit = true;
+    void Window::invalidate(const SDL_Rect &region) {
+        const SDL_Rect bounds{ 0, 0, w, h };
+        SDL_Rect clipped;
+        if (!SDL_IntersectRect(&region, &bounds, &clipped)) return;
+        if (SDL_RectEmpty(&damage))
+            damage = clipped;
+        else
+            SDL_UnionRect(&damage, &clipped, &damage);
     }
 
-    void ColorSelect::setColor(Color color) {
-        for (int i = 0; i < _countof(colSlider); ++i)
-            colSlider[i]->setVal((color >> (16 - 8 * i)) & 0xFF);
+    void Window::updateRegion(const SDL_Rect &region) {
+        SDL_SetClipRect(g.screen, &region);
+        draw();
+        SDL_SetClipRect(g.screen, NULL);
+
+        const Uint8 *pixels = (const Uint8 *)g.screen->pixels
+            + 1LL * region.y * g.screen->pitch + 4LL * region.x;
+        SDL_UpdateTexture(g.scrtex, &region, pixels, g.screen->pitch);
+        SDL_RenderCopy(g.renderer, g.scrtex, NULL, NULL);
+        SDL_RenderPresent(g.renderer);
+        damage = {};
     }
 
-    bool ColorSelect::setColor(const std::string &hexStr) {
-        if (hexStr.length() < 6) return false;
-        Color color{};
-        try {
-            //std::string s[] = { hexStr.substr(0, 2), hexStr.substr(2, 2), hexStr.substr(4, 2) };
-            //int i[] = { std::stoi(s[0], nullptr, 16), std::stoi(s[1], nullptr, 16), std::stoi(s[2], nullptr, 16) };
-            color =
-                std::stoi(hexStr.substr(0, 2), nullptr, 16) << 16 |
-                std::stoi(hexStr.substr(2, 2), nullptr, 16) << 8 |
-                std::stoi(hexStr.substr(4, 2), nullptr, 16);
+    bool Window::handleEvent(const SDL_Event &event) {
+        if (event.type == taskEvent) {
+            runTasks();
+            return true;
         }
-        catch (std::invalid_argument) {
+        if (event.type == SDL_QUIT) {
+            state = State::EXIT;
+            return true;
+        }
+        if (event.type == SDL_WINDOWEVENT) {
+            windowEvent(event.window);
             return false;
         }
-        setColor(color);
-        return true;
-    }
-
-    void ColorSelect::setWindow(Window *window) {
-        Expandable::setWindow(window);
-        if (!wasInit)
-            finalize();
-    }
+        else if (event.type != SDL_KEYUP)
+            return false;
 
-    std::string ColorSelect::hex(char c) {
-        static constexpr char hx[] = "0123456789ABCDEF";
-        return std::string{ hx[(c >> 4) & 0xF] } + hx[c & 0xF];
+        switch (event.key.keysym.sym) {
+        case SDLK_ESCAPE:
+            state = State::EXIT;
+            return true;
+        default:
+            return false;
+        }
     }
 
-    Component::EventStatus ColorSelect::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
+    void Window::events() {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (overlayEvent(event) || this->handleEvent(event))
+                continue;
+            if (modal) {
+                if (auto status = modal->handleEvent(event))
+                    if (status != Component::EventStatus::HANDLED_PARTIAL)
+                        pendingUpdate = true;
+                continue;
+            }
+            for (const auto &[_, comp] : components) {
+                if (auto status = comp->handleEvent(event)) {
+                    if (status != Component::EventStatus::HANDLED_PARTIAL)
+                        pendingUpdate = true;
+                    if (status != Component::EventStatus::FORWARDED)
+                        break;
+                }
+            }
+        }
+    }
+
+    void Window::runDeferred() {
+        if (deferred.empty()) return;
+        std::vector<Task> batch;
+        batch.swap(deferred);
+        for (auto &task : batch)
+            task();
+        pendingUpdate = true;
+    }
+
+    int Window::addPoller(Poller &&poll) {
+        (polling ? addedPollers : pollers).emplace_back(nextPollerId, std::move(poll));
+        return nextPollerId++;
+    }
+
+    void Window::removePoller(int id) {
+        const auto match = [id](const auto &p) { return p.first == id; };
+        addedPollers.erase(std::remove_if(addedPollers.begin(), addedPollers.end(), match), addedPollers.end());
+        // a poller may remove itself or others, e.g. by destroying a Tabs page
+        if (polling) {
+            for (auto &p : pollers)
+                if (p.first == id) p.first = -1;
+            return;
+        }
+        pollers.erase(std::remove_if(pollers.begin(), pollers.end(), match), pollers.end());
+    }
+
+    void Window::runPollers() {
+        polling = true;
+        for (std::size_t i = 0; i < pollers.size(); ++i)
+            if (pollers[i].first >= 0 && pollers[i].second())
+                pendingUpdate = true;
+        polling = false;
+        removePoller(-1);
+        for (auto &p : addedPollers)
+            pollers.push_back(std::move(p));
+        addedPollers.clear();
+    }
+
+    int Window::addTimer(Uint32 delay, Task &&task, bool repeat) {
+        timers.push_back({ nextTimerId, SDL_GetTicks() + delay, repeat ? delay : 0, std::move(task) });
+        return nextTimerId++;
+    }
+
+    bool Window::restartTimer(int id, Uint32 delay) {
+        for (auto &timer : timers) {
+            if (timer.id == id) {
+                timer.due = SDL_GetTicks() + delay;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Window::cancelTimer(int id) {
+        timers.erase(std::remove_if(timers.begin(), timers.end(),
+            [id](const Timer &t) { return t.id == id; }), timers.end());
+    }
+
+    void Window::runTimers() {
+        if (timers.empty()) return;
+        const Uint32 now = SDL_GetTicks();
+        // tasks may add or cancel timers, so nothing is held across the call
+        for (std::size_t i = 0; i < timers.size();) {
+            if ((Sint32)(now - timers[i].due) < 0) {
+                ++i;
+                continue;
+            }
+            Task task;
+            if (timers[i].interval) {
+                timers[i].due = now + timers[i].interval;
+                task = timers[i].task;
+                ++i;
+            }
+            else {
+                task = std::move(timers[i].task);
+                timers.erase(timers.begin() + i);
+            }
+            task();
+        }
+    }
+
+    void Window::hover(SDL_Point pos) {
+        mouse = pos;
+        if (!tipText.empty())
+            hideTooltip();
+        if (menu.isOpen()) return;
+        if (!restartTimer(hoverTimer, tooltipDelay))
+            hoverTimer = addTimer(tooltipDelay, [this] {
+                hoverTimer = -1;
+                showTooltip();
+            });
+    }
+
+    Component *Window::componentAt(SDL_Point pos, bool (*accept)(const Component &)) const {
+        // nothing behind a modal component is reachable
+        if (modal)
+            return modal->componentAt(pos, accept);
+        for (const auto &[_, comp] : components)
+            if (auto target = comp->componentAt(pos, accept))
+                return target;
+        return nullptr;
+    }
+
+    void Window::showTooltip() {
+        if (auto target = componentAt(mouse, [](const Component &c) { return !c.getTooltip().empty(); }))
+            tipText = target->getTooltip();
+        if (tipText.empty()) return;
+
+        int tw = 0, th = 0;
+        measureRuns(winfont, tipText, tw, th);
+        tipRect = { mouse.x + 12, mouse.y + 20, tw + 8, th + 4 };
+        if (tipRect.x + tipRect.w > w)
+            tipRect.x = std::max(0, w - tipRect.w);
+        if (tipRect.y + tipRect.h > h)
+            tipRect.y = std::max(0, mouse.y - tipRect.h - 4);
+        invalidate(tipRect);
+    }
+
+    void Window::hideTooltip() {
+        invalidate(tipRect);
+        tipText = {};
+    }
+
+    bool Window::overlayEvent(const SDL_Event &event) {
+        if (event.type == SDL_MOUSEMOTION)
+            hover({ event.motion.x, event.motion.y });
+        else if (event.type == SDL_MOUSEBUTTONDOWN
+            || (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_LEAVE)) {
+            cancelTimer(hoverTimer);
+            hoverTimer = -1;
+            if (!tipText.empty())
+                hideTooltip();
+        }
+
+        if (menu.isOpen()) {
+            const int hov = menu.hoveredItem();
+            const bool consumed = menu.handleEvent(event);
+            // closing may have run an action, which can change anything
+            if (!menu.isOpen())
+                pendingUpdate = true;
+            else if (menu.hoveredItem() != hov)
+                invalidate(menu.getRect());
+            return consumed;
+        }
+        if (event.type != SDL_MOUSEBUTTONDOWN || event.button.button != SDL_BUTTON_RIGHT)
+            return false;
+
+        const SDL_Point pos{ event.button.x, event.button.y };
+        auto target = componentAt(pos, [](const Component &c) { return c.hasContextMenu(); });
+        if (!target) return false;
+        menu.clear();
+        target->buildContextMenu(menu);
+        menu.show(pos, { 0, 0, w, h }, winfont);
+        if (menu.isOpen())
+            invalidate(menu.getRect());
+        return true;
+    }
+
+    void Window::windowEvent(const SDL_WindowEvent &event) {
+        switch (event.event) {
+        case SDL_WINDOWEVENT_HIDDEN:
+        case SDL_WINDOWEVENT_MINIMIZED:
+            windowShown = false;
+            break;
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_MAXIMIZED:
+            windowShown = true;
+            // catch-up frame for whatever changed while suspended
+            pendingUpdate = true;
+            break;
+        case SDL_WINDOWEVENT_EXPOSED:
+            pendingUpdate = true;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_LOST:
+            hasFocus = false;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_GAINED:
+            hasFocus = true;
+            pendingUpdate = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    Uint32 Window::frameDelay() const {
+        if (!isThrottled()) return 5;
+        const int fps = backgroundFps();
+        return fps > 0 ? std::max<Uint32>(5, 1000 / fps) : suspendedTick;
+    }
+
+    void Window::run() {
+        while (state == State::RUN) {
+            SDL_Delay(frameDelay());
+            events();
+            runDeferred();
+            runPollers();
+            runTimers();
+            // redraws pile up in pendingUpdate and damage until presentation resumes
+            if (!presenting())
+                continue;
+            if (pendingUpdate) {
+                draw();
+                update();
+                presented({ 0, 0, w, h });
+            }
+            else if (!SDL_RectEmpty(&damage)) {
+                const SDL_Rect region = damage;
+                updateRegion(region);
+                presented(region);
+            }
+        }
+    }
+
+    SDL_Surface *Window::renderFrame() {
+        runTasks();
+        runDeferred();
+        runPollers();
+        runTimers();
+        draw();
+        pendingUpdate = false;
+        damage = {};
+        if (firstFrameMs < 0)
+            firstFrameMs = elapsedMs(startTicks);
+        return g.screen;
+    }
+
+    void Window::clearComponents() {
+        modal = nullptr;
+        menu.close();
+        tipText = {};
+        hoverTimer = -1;
+        timers.clear();
+        deferred.clear();
+        components.clear();
+        pendingUpdate = true;
+    }
+
+    int Window::addPresentHook(PresentHook &&hook) {
+        presentHooks.emplace_back(nextPresentHookId, std::move(hook));
+        return nextPresentHookId++;
+    }
+
+    void Window::removePresentHook(int id) {
+        presentHooks.erase(std::remove_if(presentHooks.begin(), presentHooks.end(),
+            [id](const auto &p) { return p.first == id; }), presentHooks.end());
+    }
+
+    void Window::presented(const SDL_Rect &region) {
+        for (std::size_t i = 0; i < presentHooks.size(); ++i)
+            presentHooks[i].second(region);
+    }
+
+    void Component::mapColors(const Graphics &g) {
+        int index = 0;
+        auto cols = colors.ptrs();
+        for (auto raw : rawColors.ptrs())
+            *cols[index++] = g.color(*raw);
+    }
+
+    Component *Component::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        return shown && posInside(pos) && accept(*this) ? this : nullptr;
+    }
+
+    bool Component::handleHoverHL(const SDL_Event &event) {
+        if (event.type == SDL_MOUSEMOTION 
+            && posInside({ event.button.x, event.button.y }) != hovered) {
+            hovered ^= true;
+            return true;
+        }
+        return false;
+    }
+
+    int Component::thisWasClicked(const SDL_Event &event) const {
+        if (event.type == SDL_MOUSEBUTTONDOWN 
+            && posInside({ event.button.x, event.button.y }))
+            return event.button.clicks;
+        return 0;
+    }
+
+    int Component::clickOutside(const SDL_Event &event) const {
+        if (event.type == SDL_MOUSEBUTTONDOWN
+            && !posInside({ event.button.x, event.button.y }))
+            return event.button.clicks;
+        return 0;
+    }
+
+    Component::EventStatus Panel::handleEvent(const SDL_Event &event) {
+        if (!shown) return EventStatus::IGNORED;
+        return multihandleEvent(event, comps);
+        //for (const auto &comp : comps)
+        //    if (auto status = comp->handleEvent(event))
+        //        return EventStatus::HANDLED;
+        //return EventStatus::IGNORED;
+    }
+
+    void Panel::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, colors.bg, colors.line);
+        for (const auto &comp : comps)
+            comp->draw(g);
+    }
+
+    void Panel::setWindow(Window *window) {
+        Component::setWindow(window);
+        for (const auto &comp : comps) {
+            comp->setWindow(win);
+            comp->mapColors(win->graphics());
+        }
+    }
+
+    Component *Panel::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown || !posInside(pos)) return nullptr;
+        for (auto it = comps.rbegin(); it != comps.rend(); ++it)
+            if (auto found = (*it)->componentAt(pos, accept))
+                return found;
+        return accept(*this) ? this : nullptr;
+    }
+
+    void Panel::translate(int x, int y) {
+        Component::translate(x, y);
+        for (auto &comp : comps)
+            comp->translate(x, y);
+    }
+    
+    Component *Panel::addComponent(std::unique_ptr<Component> &&comp) {
+        if (win) {
+            comp->setWindow(win);
+            comp->mapColors(win->graphics());
+        }
+        comps.push_back(std::move(comp));
+
+        return comps.back().get();
+    }
+
+    void ScrollPanel::translate(int x, int y) {
+        Panel::translate(x, y);
+        if (bar) bar->translate(x, y);
+        scrollBegin.x += x;
+        scrollBegin.y += y;
+    }
+
+    void ScrollPanel::showScrollbar(int width) {
+        if (width <= 0) {
+            bar = nullptr;
+            return;
+        }
+        const SDL_Rect r{ rect.x + rect.w - width, rect.y, width, rect.h };
+        bar = std::make_unique<ScrollBar>(r, rawColors, this);
+        if (win) {
+            bar->setWindow(win);
+            bar->mapColors(win->graphics());
+        }
+    }
+
+    void ScrollPanel::setWindow(Window *window) {
+        Panel::setWindow(window);
+        if (bar) {
+            bar->setWindow(window);
+            bar->mapColors(window->graphics());
+        }
+    }
+
+    void ScrollPanel::draw(Graphics &g) {
+        Panel::draw(g);
+        if (shown && bar)
+            bar->draw(g);
+    }
+
+    Component::EventStatus ScrollPanel::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (bar && bar->handleEvent(event)) return HANDLED;
+        if (Panel::handleEvent(event)) return HANDLED;
+        if (event.type != SDL_MOUSEWHEEL) return IGNORED;
+
+        int offset = sgn(event.wheel.y);
+        if (index + offset >= 0 && index + offset + numShown <= (int)comps.size()) {
+            index += offset;
+            refreshVisible();
+        }
+        return HANDLED;
+    }
+
+    Component *ScrollPanel::addComponent(std::unique_ptr<Component> &&comp) {
+        auto ret = Panel::addComponent(std::move(comp));
+        ret->hide();
+        if (inWindow((int)comps.size() - 1, (int)comps.size()))
+            refreshVisible();
+        return ret;
+    }
+
+    void ScrollPanel::applyChange(const ListChange &change, const RowBuilder &build) {
+        switch (change.kind) {
+        case ListChange::INSERTED:
+            insertRows(change.first, build(change.first, change.count));
+            break;
+        case ListChange::REMOVED:
+            removeRows(change.first, change.count);
+            break;
+        case ListChange::MOVED:
+            moveRows(change.first, change.count, change.to);
+            break;
+        case ListChange::CHANGED:
+            replaceRows(change.first, build(change.first, change.count));
+            break;
+        case ListChange::RESET:
+            removeRows(0, (int)comps.size());
+            insertRows(0, build(0, change.count));
+            break;
+        default:
+            break;
+        }
+    }
+
+    void ScrollPanel::insertRows(int pos, CompVec &&rows) {
+        if (rows.empty()) return;
+        prepareRows(rows);
+        comps.insert(comps.begin() + pos,
+            std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+        if (pos < index + numShown)
+            refreshVisible();
+    }
+
+    void ScrollPanel::removeRows(int first, int count) {
+        if (count <= 0) return;
+        const bool affected = first < index + numShown;
+        if (affected)
+            hideVisible();
+        comps.erase(comps.begin() + first, comps.begin() + first + count);
+        if (affected)
+            refreshVisible();
+    }
+
+    void ScrollPanel::moveRows(int first, int count, int to) {
+        if (count <= 0 || first == to) return;
+        if (to < first)
+            std::rotate(comps.begin() + to, comps.begin() + first, comps.begin() + first + count);
+        else
+            std::rotate(comps.begin() + first, comps.begin() + first + count, comps.begin() + to + count);
+        if (inWindow(std::min(first, to), std::max(first, to) + count))
+            refreshVisible();
+    }
+
+    void ScrollPanel::replaceRows(int first, CompVec &&rows) {
+        const int count = (int)rows.size();
+        const bool affected = inWindow(first, first + count);
+        if (affected)
+            hideVisible();
+        prepareRows(rows);
+        std::move(rows.begin(), rows.end(), comps.begin() + first);
+        if (affected)
+            refreshVisible();
+    }
+
+    void ScrollPanel::scrollContent() {
+        for (auto &comp : comps)
+            comp->hide();
+        visible.clear();
+        refreshVisible();
+    }
+
+    void ScrollPanel::refreshVisible() {
+        hideVisible();
+        index = std::max(0, std::min(index, (int)comps.size() - numShown));
+        const int end = std::min(index + numShown, (int)comps.size());
+        int yoff = 0;
+        for (int i = index; i < end; ++i) {
+            auto &cur = *comps[i];
+            cur.show();
+            cur.setPos(scrollBegin.x, scrollBegin.y + yoff);
+            yoff += cur.h();
+            visible.push_back(&cur);
+        }
+    }
+
+    void ScrollPanel::prepareRows(CompVec &rows) {
+        for (auto &row : rows) {
+            if (win) {
+                row->setWindow(win);
+                row->mapColors(win->graphics());
+            }
+            row->hide();
+        }
+    }
+
+    void ScrollPanel::hideVisible() {
+        for (auto comp : visible)
+            comp->hide();
+        visible.clear();
+    }
+
+    SDL_Rect ScrollBar::thumbRect() const {
+        const int total = target ? target->scrollTotal() : 0;
+        const int page = target ? target->scrollPage() : 0;
+        if (total <= page)
+            return rect;
+        const int th = std::max(minThumb, (int)(1LL * rect.h * page / total));
+        const int y = (int)(1LL * (rect.h - th) * target->scrollPos() / (total - page));
+        return { rect.x, rect.y + y, rect.w, th };
+    }
+
+    int ScrollBar::posAt(int thumbY) const {
+        const int total = target->scrollTotal(), page = target->scrollPage();
+        const int free = rect.h - thumbRect().h;
+        if (free <= 0 || total <= page) return 0;
+        return (int)std::lround(1. * (thumbY - rect.y) * (total - page) / free);
+    }
+
+    void ScrollBar::jumpTo(int y) {
+        if (!target) return;
+        target->scrollTo(posAt(y - thumbRect().h / 2));
+    }
+
+    Component::EventStatus ScrollBar::handleEvent(const SDL_Event &event) {
+        if (!shown || !target) return IGNORED;
+        switch (event.type) {
+        case SDL_MOUSEBUTTONDOWN: {
+            if (!thisWasClicked(event)) return IGNORED;
+            const SDL_Rect thumb = thumbRect();
+            const SDL_Point p{ event.button.x, event.button.y };
+            if (SDL_PointInRect(&p, &thumb)) {
+                dragging = true;
+                grabOffset = p.y - thumb.y;
+            }
+            else if (event.button.button == SDL_BUTTON_MIDDLE || (SDL_GetModState() & KMOD_SHIFT)) {
+                jumpTo(p.y);
+            }
+            else {
+                const int page = target->scrollPage();
+                target->scrollTo(target->scrollPos() + (p.y < thumb.y ? -page : page));
+            }
+            return HANDLED;
+        }
+        case SDL_MOUSEMOTION:
+            if (!dragging) return IGNORED;
+            target->scrollTo(posAt(event.motion.y - grabOffset));
+            return HANDLED;
+        case SDL_MOUSEBUTTONUP:
+            if (!dragging) return IGNORED;
+            dragging = false;
+            return HANDLED;
+        default:
+            return IGNORED;
+        }
+    }
+
+    void ScrollBar::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, colors.bg, colors.line);
+        g.drawRect(thumbRect(), 1, dragging ? colors.hl : colors.extra1, colors.line);
+    }
+
+    ListView::ListView(SDL_Rect rect, const CompColors &colors, int numShown) :
+        Panel(rect, colors.bg, colors.line), numShown(numShown) {
+        rawColors = colors;
+        const int rowH = rect.h / numShown;
+        for (int i = 0; i < numShown; ++i) {
+            const SDL_Rect r{ rect.x, rect.y + i * rowH, rect.w, rowH };
+            Panel::addComponent(std::make_unique<Row>(r, colors, i, this));
+        }
+    }
+
+    void ListView::setItems(std::vector<std::string> &&newItems) {
+        items = std::move(newItems);
+        selected = -1;
+        first = 0;
+    }
+
+    void ListView::updateItems(std::vector<std::string> &&newItems, int newSelection) {
+        items = std::move(newItems);
+        selected = newSelection < itemCount() ? newSelection : -1;
+        scrollTo(first);
+    }
+
+    void ListView::scrollTo(int index) {
+        first = std::max(0, std::min(index, itemCount() - numShown));
+    }
+
+    void ListView::moveSelection(int delta) {
+        if (items.empty()) return;
+        selected = std::max(0, std::min(selected + delta, itemCount() - 1));
+        if (selected < first)
+            scrollTo(selected);
+        else if (selected >= first + numShown)
+            scrollTo(selected - numShown + 1);
+    }
+
+    void ListView::select(int index) {
+        if (index < 0 || index >= itemCount()) return;
+        selected = index;
+        if (onSelect)
+            onSelect(index, items[index]);
+    }
+
+    Component::EventStatus ListView::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (Panel::handleEvent(event)) return HANDLED;
+        if (event.type != SDL_MOUSEWHEEL) return IGNORED;
+
+        scrollTo(first + sgn(event.wheel.y));
+        return HANDLED;
+    }
+
+    Component::EventStatus ListView::Row::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (handleHoverHL(event)) return HANDLED;
+        if (thisWasClicked(event)) {
+            list->select(list->first + slot);
+            return HANDLED;
+        }
+        return IGNORED;
+    }
+
+    void ListView::Row::draw(Graphics &g) {
+        const int index = list->first + slot;
+        if (!shown || index >= list->itemCount()) return;
+        const bool hl = hovered || index == list->selected;
+        g.drawRect(rect, 1, hl ? colors.hl : colors.bg, colors.line);
+        g.drawString(rect, list->items[index], win->font(), colors.text);
+    }
+
+    Component::EventStatus Button::handleEvent(const SDL_Event &event) {
+        if (!shown || !callback) return IGNORED;
+        if (handleHoverHL(event)) return HANDLED;
+        if (thisWasClicked(event)) {
+            callback(this);
+            return HANDLED;
+        }
+        return IGNORED;
+    }
+
+    void Button::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
+        g.drawString(rect, text, win->font(), colors.text);
+    }
+
+    Expandable::Expandable(SDL_Rect rect, std::string_view text, const CompColors &colors,
+        std::unique_ptr<Panel> &&panel, ExpandDir expDir) :
+        Component(rect, colors), text(text), panel(std::move(panel)) {
+        if (win) {
+            this->panel->setWindow(win);
+            this->panel->mapColors(win->graphics());
+        }
+        this->panel->hide();
+        setExpandDir(expDir);
+    }
+
+    void Expandable::setExpandDir(ExpandDir dir) {
+        switch (dir) {
+        case ExpandDir::UP:
+            expOffset = { 0, -panel->h() };
+            break;
+        case ExpandDir::DOWN:
+            expOffset = { 0, h() };
+            break;
+        case ExpandDir::LEFT_UP:
+            expOffset = { -panel->w(), -(panel->h() - h()) };
+            break;
+        case ExpandDir::RIGHT_UP:
+            expOffset = { w(), -(panel->h() - h()) };
+            break;
+        case ExpandDir::LEFT_DOWN:
+            expOffset = { -panel->w(), 0 };
+            break;
+        case ExpandDir::RIGHT_DOWN:
+            expOffset = { w(), 0 };
+            break;
+        default:
+            break;
+        }
+        adjustPanel();
+    }
+
+    void Expandable::setWindow(Window *window) {
+        Component::setWindow(window);
+        panel->setWindow(window);
+        panel->mapColors(win->graphics());
+    }
+
+    Component *Expandable::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown) return nullptr;
+        if (expanded)
+            if (auto found = panel->componentAt(pos, accept))
+                return found;
+        return Component::componentAt(pos, accept);
+    }
+
+    Component::EventStatus Expandable::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (handleHoverHL(event)) return HANDLED;
+        if (panel->handleEvent(event)) return HANDLED;
+        if (thisWasClicked(event) == 1) {
+            toggleExpanded();
+            return FORWARDED;
+        }
+        if (event.type == SDL_MOUSEBUTTONDOWN
+            && expanded
+            && !panel->posInside({ event.button.x, event.button.y })) {
+            setExpanded(false);
+            return FORWARDED;
+        }
+        return IGNORED;
+    }
+
+    void Expandable::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
+        g.drawString(rect, text, win->font(), colors.text);
+        panel->draw(g);
+    }
+
+    void Expandable::translate(int x, int y) {
+        Component::translate(x, y);
+        panel->translate(x, y);
+    }
+
+    Component::EventStatus ComboBox::Elem::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (handleHoverHL(event)) return HANDLED;
+        if (thisWasClicked(event)) {
+            comboBox->setSelection(ind);
+            comboBox->setExpanded(false);
+            return HANDLED;
+        }
+        return IGNORED;
+    }
+
+    void ComboBox::Elem::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
+        g.drawString(rect, text, win->font(), colors.text);
+    }
+
+    std::unique_ptr<ScrollPanel> ComboBox::makePanel(int numShown) {
+        const SDL_Rect panelRect{ 0, 0, w(), h() * numShown };
+        return std::make_unique<ScrollPanel>(panelRect, rawColors.bg,
+            rawColors.line, numShown);
+    }
+
+    void ComboBox::setWindow(Window *window) {
+        Expandable::setWindow(window);
+        if (!wasInit)
+            finalizePanel();
+    }
+
+    void ComboBox::finalizePanel() {
+        for (int i = 0; i < (int)options.size(); ++i)
+            panel->addComponent(std::make_unique<Elem>(rect, rawColors, i, options[i], this));
+        panel->rawColors = rawColors;
+        panel->setWindow(win);
+        wasInit = true;
+    }
+
+    void ComboBox::bind(std::shared_ptr<ListModel<std::string>> model) {
+        unbind();
+        applyChange({ ListChange::RESET, 0, model->size() }, *model);
+        unbinder = ListModel<std::string>::observe(model,
+            [this, m = model.get()](const ListChange &change) { applyChange(change, *m); });
+    }
+
+    void ComboBox::bind(std::shared_ptr<Observable<int>> selection) {
+        unbindSelection();
+        boundSel = selection;
+        selUnbinder = Observable<int>::observe(std::move(selection), [this](const int &ind) {
+            if (ind != index && ind >= 0 && ind < (int)options.size())
+                setSelection(ind);
+        });
+        const int ind = boundSel->get();
+        if (ind >= 0 && ind < (int)options.size())
+            setSelection(ind);
+    }
+
+    void ComboBox::applyChange(const ListChange &change, const ListModel<std::string> &model) {
+        const int first = change.first, count = change.count;
+        switch (change.kind) {
+        case ListChange::INSERTED:
+            options.insert(options.begin() + first,
+                model.data().begin() + first, model.data().begin() + first + count);
+            break;
+        case ListChange::REMOVED:
+            options.erase(options.begin() + first, options.begin() + first + count);
+            break;
+        case ListChange::MOVED:
+            if (change.to < first)
+                std::rotate(options.begin() + change.to,
+                    options.begin() + first, options.begin() + first + count);
+            else
+                std::rotate(options.begin() + first,
+                    options.begin() + first + count, options.begin() + change.to + count);
+            break;
+        case ListChange::CHANGED:
+            std::copy_n(model.data().begin() + first, count, options.begin() + first);
+            break;
+        case ListChange::RESET:
+            options = model.data();
+            break;
+        default:
+            break;
+        }
+
+        const int sel = change.remap(index);
+        index = std::max(0, std::min(sel, (int)options.size() - 1));
+        text = options.empty() ? "" : options[index];
+        if (!wasInit) return;
+
+        auto sp = static_cast<ScrollPanel *>(panel.get());
+        sp->applyChange(change, [this](int from, int n) {
+            Panel::CompVec rows;
+            for (int i = from; i < from + n; ++i)
+                rows.push_back(std::make_unique<Elem>(rect, rawColors, i, options[i], this));
+            return rows;
+        });
+        auto &elems = sp->components();
+        const int from = change.kind == ListChange::MOVED ? std::min(first, change.to) : first;
+        for (int i = from; i < (int)elems.size(); ++i)
+            static_cast<Elem *>(elems[i].get())->setIndex(i);
+    }
+
+    void Slider::translate(int x, int y) {
+        Component::translate(x, y);
+        sliderRect.x += x;
+        sliderRect.y += y;
+    }
+
+    Component::EventStatus Slider::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        const SDL_Point p = { event.button.x, event.button.y };
+        const bool inRect = SDL_PointInRect(&p, &sliderRect);
+        switch (event.type) {
+        case SDL_MOUSEMOTION:
+            if (hovered != inRect) {
+                hovered = inRect;
+                return HANDLED;
+            }
+            if (dragging) {
+                dragDiff(p - mousePos);
+                checkCallback();
+                mousePos = p;
+                return HANDLED;
+            }
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            if (inRect) {
+                mousePos = p;
+                dragging = true;
+                return HANDLED;
+            }
+            break;
+        case SDL_MOUSEBUTTONUP:
+            dragging = false;
+            return FORWARDED;
+        default:
+            break;
+        }
+        return IGNORED;
+    }
+
+    void Slider::draw(Graphics &g) {
+        if (!shown) return;
+        g.drawRect(rect, 1, colors.extra1, colors.line);
+        drawThumb(g);
+    }
+
+    void Slider::drawThumb(Graphics &g) {
+        g.drawRect(sliderRect, 1,
+            (hovered || dragging) ? colors.hl : colors.bg, colors.line);
+    }
+
+    SDL_Rect Slider::makeSliderRect(int w) const {
+        if (vertical) {
+            return { rect.x - w / 2, rect.y, rect.w + w, w };
+        }
+        return { rect.x, rect.y - w / 2, w, rect.h + w };
+    }
+
+    void Slider::bind(std::shared_ptr<Observable<int>> obs) {
+        unbind();
+        bound = obs;
+        setVal(obs->get());
+        unbinder = Observable<int>::observe(std::move(obs), [this](const int &v) {
+            if (v != trueVal())
+                setVal(v);
+        });
+    }
+
+    void Slider::checkCallback() {
+        const int nv = trueVal();
+        if (nv != lastVal) {
+            lastVal = nv;
+            if (onValChange)
+                onValChange(nv);
+            if (bound)
+                bound->set(nv);
+        }
+    }
+
+    void Slider::dragDiff(SDL_Point dp) {
+        if (vertical) {
+            val += (dp.y * upp());
+            capVal();
+            sliderRect.y = rect.y + static_cast<int>(std::round(stepn() * pps()));
+        }
+        else {
+            val += (dp.x * upp());
+            capVal();
+            sliderRect.x = rect.x + static_cast<int>(std::round(stepn() * pps()));
+        }
+    }
+
+    void Slider::capVal() {
+        if (val > max)
+            val = float(max);
+        else if (val < min)
+            val = float(min);
+    }
+
+    Color ColorSelect::color() const {
+        return
+            colSlider[0]->trueVal() << 16 | 
+            colSlider[1]->trueVal() << 8 | 
+            colSlider[2]->trueVal();
+    }
+
+    std::string ColorSelect::str() const {
+        return 
+            hex(colSlider[0]->trueVal()) +
+            hex(colSlider[1]->trueVal()) +
+            hex(colSlider[2]->trueVal());
+    }
+
+    std::unique_ptr<Panel> ColorSelect::makePanel() const {
+        return std::make_unique<Panel>(SDL_Rect{ 0,0,350,140 }, 0, 0);
+    }
+
+    std::unique_ptr<TextInput> ColorSelect::makeInput() {
+        auto input = std::make_unique<TextInput>(
+            SDL_Rect{rect.x + rect.w, rect.y, rect.w, 30}, 
+            rawColors, "", true);
+        input->setCallback([csel = this](const std::string &val) {
+            csel->setColor(val);
+        });
+        return input;
+    }
+
+    void ColorSelect::finalize() {
+        CompColors cols = rawColors;
+        for (int i = 0; i < _countof(colSlider); ++i) {
+            SDL_Rect r{panel->x() + 70, panel->y() + 30 + 35 * i, 255, 13};
+            cols.bg = 0xFF0000 >> (8 * i);
+            colSlider[i] = panel->addComponent(
+                std::make_unique<Slider>(r, 0, 255, 1, cols, false, 13)
+            )->as<Slider>();
+        }
+        panel->rawColors = rawColors;
+        panel->setWindow(win);
+        panel->mapColors(win->graphics());
+        input->setWindow(win);
+        input->mapColors(win->graphics());
+        wasInit = true;
+    }
+
+    void ColorSelect::setColor(Color color) {
+        for (int i = 0; i < _countof(colSlider); ++i)
+            colSlider[i]->setVal((color >> (16 - 8 * i)) & 0xFF);
+    }
+
+    bool ColorSelect::setColor(const std::string &hexStr) {
+        if (hexStr.length() < 6) return false;
+        Color color{};
+        try {
+            //std::string s[] = { hexStr.substr(0, 2), hexStr.substr(2, 2), hexStr.substr(4, 2) };
+            //int i[] = { std::stoi(s[0], nullptr, 16), std::stoi(s[1], nullptr, 16), std::stoi(s[2], nullptr, 16) };
+            color =
+                std::stoi(hexStr.substr(0, 2), nullptr, 16) << 16 |
+                std::stoi(hexStr.substr(2, 2), nullptr, 16) << 8 |
+                std::stoi(hexStr.substr(4, 2), nullptr, 16);
+        }
+        catch (std::invalid_argument) {
+            return false;
+        }
+        setColor(color);
+        return true;
+    }
+
+    void ColorSelect::setWindow(Window *window) {
+        Expandable::setWindow(window);
+        if (!wasInit)
+            finalize();
+    }
+
+    std::string ColorSelect::hex(char c) {
+        static constexpr char hx[] = "0123456789ABCDEF";
+        return std::string{ hx[(c >> 4) & 0xF] } + hx[c & 0xF];
+    }
+
+    Component *ColorSelect::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown) return nullptr;
+        if (auto found = input->componentAt(pos, accept))
+            return found;
+        return Expandable::componentAt(pos, accept);
+    }
+
+    Component::EventStatus ColorSelect::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
         if (thisWasClicked(event)) {
             if (input->isVisible()) {
                 input->deactivate();
                 toggleExpanded();
                 return HANDLED;
             }
-            if (expanded) {
-                input->clear();
-                input->activate();
-                return HANDLED;
+            if (expanded) {
+                input->clear();
+                input->activate();
+                return HANDLED;
+            }
+        }
+        if (input->handleEvent(event))
+            return HANDLED;
+        return Expandable::handleEvent(event);
+    }
+
+    void ColorSelect::draw(Graphics &g) {
+        if (!shown) return;
+        Color cur = g.color(color());
+        text = std::string{ '#' } + str();
+        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
+        g.drawString(rect, text, win->font(), colors.text);
+        g.drawRect({rect.x + 10, rect.y + 10, 20, 20}, 1, cur, colors.line);
+        if (expanded) {
+            panel->draw(g);
+            g.drawRect({ panel->x() + 20, panel->y() + 20, 30, 100 }, 1, cur, colors.line);
+        }
+        input->draw(g);
+    }
+    
+    void TextInput::activate() {
+        active = true;
+        SDL_StartTextInput();
+        if (autoHide)
+            show();
+    }
+
+    void TextInput::deactivate() {
+        commitPending();
+        active = false;
+        SDL_StopTextInput();
+        if (autoHide)
+            hide();
+        if (onConfirm)
+            onConfirm(text);
+    }
+
+    Component::EventStatus TextInput::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (!active && thisWasClicked(event)) {
+            activate();
+            return HANDLED;
+        }
+        if (active) {
+            if (clickOutside(event)) {
+                deactivate();
+                return IGNORED;
+            }
+            if (event.type == SDL_TEXTINPUT) {
+                // merged into a single edit on the next key press or draw
+                pending += event.text.text;
+                return HANDLED;
+            }
+            if (event.type == SDL_KEYDOWN)
+                return handleKey(event.key.keysym.sym) ? HANDLED : IGNORED;
+        }
+        return IGNORED;
+    }
+
+    bool TextInput::handleKey(int kp) {
+        commitPending();
+        const std::size_t oldLen = text.length();
+        switch (kp) {
+        case SDLK_LEFT:
+            caretPos = charBoundary(caretPos, -1);
+            break;
+        case SDLK_RIGHT:
+            caretPos = charBoundary(caretPos, 1);
+            break;
+        case SDLK_HOME:
+            caretPos = 0;
+            break;
+        case SDLK_END:
+            caretPos = (int)text.length();
+            break;
+        case SDLK_DELETE:
+            deleteChar(caretPos);
+            break;
+        case SDLK_BACKSPACE:
+            if (caretPos > 0)
+                deleteChar(caretPos = charBoundary(caretPos, -1));
+            break;
+        case SDLK_v:
+            if (!(SDL_GetModState() & KMOD_CTRL))
+                return false;
+            paste();
+            break;
+        case SDLK_KP_ENTER:
+        case SDLK_RETURN:
+        case SDLK_RETURN2:
+            deactivate();
+            break;
+        default:
+            return false;
+        }
+        if (caretPos < 0)
+            caretPos = 0;
+        if (caretPos > (int)text.length())
+            caretPos = (int)text.length();
+        if (text.length() != oldLen)
+            notifyChange();
+        return true;
+    }
+
+    void TextInput::draw(Graphics &g) {
+        if (!shown) return;
+        commitPending();
+        g.drawRect(rect, 1, active ? colors.hl : colors.bg, colors.line);
+        g.drawString({rect.x + 10,rect.y,rect.w,rect.h},
+            text, win->font(), colors.text, false);
+    }
+
+    void TextInput::deleteChar(std::size_t index) {
+        if (index >= text.length()) return;
+        text.erase(index, charBoundary((int)index, 1) - index);
+    }
+
+    void TextInput::insertChar(char chr, std::size_t index) {
+        if (index > text.length()) return;
+        text.insert(text.begin() + index, chr);
+    }
+
+    void TextInput::insertText(std::string_view str, std::size_t index) {
+        if (index > text.length()) return;
+        text.insert(index, str.data(), str.size());
+    }
+
+    void TextInput::paste() {
+        if (!SDL_HasClipboardText()) return;
+        char *clip = SDL_GetClipboardText();
+        if (!clip) return;
+        for (const char *p = clip; *p; ++p) {
+            if (*p == '\n' || *p == '\t')
+                pending += ' ';
+            else if (*p != '\r')
+                pending += *p;
+        }
+        SDL_free(clip);
+    }
+
+    void TextInput::setValue(std::string_view val) {
+        text = val;
+        pending.clear();
+        caretPos = (int)text.length();
+        notifyChange();
+    }
+
+    void TextInput::commitPending() {
+        if (pending.empty()) return;
+        insertText(pending, caretPos);
+        caretPos += (int)pending.length();
+        pending.clear();
+        notifyChange();
+    }
+
+    void TextInput::notifyChange() {
+        if (onChange)
+            onChange(text);
+        if (bound)
+            bound->set(text);
+    }
+
+    void TextInput::bind(std::shared_ptr<Observable<std::string>> obs) {
+        unbind();
+        setValue(obs->get());
+        bound = obs;
+        unbinder = Observable<std::string>::observe(std::move(obs), [this](const std::string &v) {
+            if (v != value())
+                setValue(v);
+        });
+    }
+
+    int TextInput::charBoundary(int pos, int dir) const {
+        const int len = (int)text.length();
+        pos += dir;
+        // skip UTF-8 continuation bytes
+        while (pos > 0 && pos < len && (text[pos] & 0xC0) == 0x80)
+            pos += dir;
+        return pos < 0 ? 0 : (pos > len ? len : pos);
+    }
+
+    Dropdown::MiniPanel::MiniPanel(std::unique_ptr<Component> &&comp,
+        Dropdown *parent, bool allowDel, bool allowSwap) :
+        Component(SDL_Rect{}, parent->rawColors),
+        mainPart(std::move(comp)), parent(parent) {
+        if (allowDel) {
+            const SDL_Rect r{
+                mainPart->x() + mainPart->w() + 2 * buttonSize + 3 * buttonSpace,
+                mainPart->y() + (mainPart->h() - buttonSize) / 2,
+                buttonSize,
+                buttonSize
+            };
+            del = std::make_unique<Button>(r, "X", rawColors,
+                [this](Button *) { this->parent->removeAt(index); });
+        }
+        if (allowSwap) {
+            SDL_Rect r{
+                mainPart->x() + mainPart->w() + buttonSpace,
+                mainPart->y() + (mainPart->h() - buttonSize) / 2,
+                buttonSize,
+                buttonSize
+            };
+            up = std::make_unique<Button>(r, "U", rawColors,
+                [this](Button *) { this->parent->swapElems(index, index - 1); });
+            r.x += (buttonSize + buttonSpace);
+            down = std::make_unique<Button>(r, "D", rawColors,
+                [this](Button *) { this->parent->swapElems(index, index + 1); });
+        }
+    }
+
+    void Dropdown::MiniPanel::translate(int x, int y) {
+        Component::translate(x, y);
+        mainPart->translate(x, y);
+        if (up) up->translate(x, y);
+        if (down) down->translate(x, y);
+        if (del) del->translate(x, y);
+    }
+
+    Component *Dropdown::MiniPanel::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        // the panel's own rect is empty, its parts are placed side by side
+        if (!shown) return nullptr;
+        for (Component *c : { (Component *)del.get(), (Component *)down.get(), (Component *)up.get(), mainPart.get() })
+            if (c)
+                if (auto found = c->componentAt(pos, accept))
+                    return found;
+        return Component::componentAt(pos, accept);
+    }
+
+    void Dropdown::MiniPanel::setWindow(Window *window) {
+        Component::setWindow(window);
+        mainPart->setWindow(window);
+        if (up) up->setWindow(window);
+        if (down) down->setWindow(window);
+        if (del) del->setWindow(window);
+        mainPart->mapColors(window->graphics());
+        if (up) up->mapColors(window->graphics());
+        if (down) down->mapColors(window->graphics());
+        if (del) del->mapColors(window->graphics());
+    }
+
+    Component::EventStatus Dropdown::MiniPanel::handleEvent(const SDL_Event &event) {
+        return shown && (mainPart->handleEvent(event)
+            || (up && up->handleEvent(event))
+            || (down && down->handleEvent(event))
+            || (del && del->handleEvent(event))) ? HANDLED : IGNORED;
+    }
+
+    void Dropdown::MiniPanel::draw(Graphics &g) {
+        if (!shown) return;
+        mainPart->draw(g);
+        if (up) up->draw(g);
+        if (down) down->draw(g);
+        if (del) del->draw(g);
+    }
+
+    Dropdown::Dropdown(SDL_Rect rect, SDL_Rect elemRect, std::string_view text,
+        short flags, int numShown, const CompColors &colors, ExpandDir expDir) :
+        Expandable(rect, text, colors, makePanel(elemRect, numShown), expDir),
+        elemRect(elemRect), flags(flags), elems(panel->components()) {
+
+        panel->rawColors = rawColors;
+        if (flags & Flags::ADD) {
+            const SDL_Rect r{
+                panel->x() + buttonSpace,
+                panel->y() + panel->h() - (elemRect.h + buttonSize) / 2,
+                buttonSize, buttonSize
+            };
+            addButton = std::make_unique<Button>(r, "+", rawColors, [this](Button *) {
+                if (modelAdd)
+                    modelAdd();
+                else if (addFactory)
+                    addComponent(addFactory((int)elems.size()));
+            });
+        }
+    }
+
+    std::unique_ptr<Dropdown::MiniPanel> Dropdown::wrap(std::unique_ptr<Component> &&comp) {
+        auto mp = std::make_unique<MiniPanel>(std::move(comp), this,
+            flags & Flags::DEL, flags & Flags::SWAP);
+        mp->rawColors = rawColors;
+        mp->index = (int)elems.size();
+        if (win)
+            mp->setWindow(win);
+        mp->setDims(elemRect.w + 4 * buttonSpace + 3 * buttonSize, elemRect.h);
+        return mp;
+    }
+
+    Component *Dropdown::addComponent(std::unique_ptr<Component> &&comp) {
+        return panel->addComponent(wrap(std::move(comp)))->as<MiniPanel>()->mainPart.get();
+    }
+
+    void Dropdown::removeAt(int index) {
+        if (index < 0 || index >= (int)elems.size()) return;
+        if (modelEdit) {
+            modelEdit({ ListChange::REMOVED, index, 1 });
+            return;
+        }
+        scrollPanel()->removeRows(index, 1);
+        reindex(index);
+    }
+
+    void Dropdown::swapElems(int ind1, int ind2) {
+        if (ind1 < 0
+            || ind2 < 0
+            || ind1 >= (int)elems.size()
+            || ind2 >= (int)elems.size())
+            return;
+
+        const int lo = std::min(ind1, ind2), hi = std::max(ind1, ind2);
+        if (modelEdit) {
+            modelEdit({ ListChange::MOVED, hi, 1, lo });
+            modelEdit({ ListChange::MOVED, lo + 1, 1, hi });
+            return;
+        }
+        std::swap(elems[ind1], elems[ind2]);
+        std::swap(
+            elems[ind1]->as<MiniPanel>()->index,
+            elems[ind2]->as<MiniPanel>()->index
+        );
+        if (elems[ind1]->isVisible() || elems[ind2]->isVisible())
+            scrollPanel()->refreshVisible();
+    }
+
+    void Dropdown::applyChange(const ListChange &change, const ScrollPanel::RowBuilder &build) {
+        scrollPanel()->applyChange(change, [this, &build](int first, int count) {
+            Panel::CompVec rows = build(first, count);
+            for (auto &row : rows)
+                row = wrap(std::move(row));
+            return rows;
+        });
+        reindex(change.kind == ListChange::MOVED ? std::min(change.first, change.to) : change.first);
+    }
+
+    void Dropdown::setWindow(Window *window) {
+        Expandable::setWindow(window);
+        addButton->setWindow(window);
+        addButton->mapColors(window->graphics());
+    }
+
+    void Dropdown::setFactory(FactoryCallback &&fcb) {
+        addFactory = std::move(fcb);
+    }
+
+    void Dropdown::draw(Graphics &g) {
+        Expandable::draw(g);
+        if (shown && expanded)
+            addButton->draw(g);
+    }
+
+    Component::EventStatus Dropdown::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (auto stat = addButton->handleEvent(event))
+            return stat;
+        return Expandable::handleEvent(event);
+    }
+
+    std::unique_ptr<ScrollPanel> Dropdown::makePanel(const SDL_Rect &rect, int numShown) {
+        const SDL_Rect panelRect{ 0, 0,
+            rect.w + 4 * buttonSpace + 3 * buttonSize, rect.h * (numShown + 1) };
+        return std::make_unique<ScrollPanel>(panelRect, 0, 0, numShown);
+    }
+
+    void Dropdown::reindex(int from) {
+        for (std::size_t i = from; i < elems.size(); ++i) {
+            elems[i]->as<MiniPanel>()->index = (int)i;
+        }
+    }
+
+    PrefixIndex::PrefixIndex(std::vector<std::string> &&keys) : keys(std::move(keys)) {
+        std::sort(this->keys.begin(), this->keys.end());
+        this->keys.erase(std::unique(this->keys.begin(), this->keys.end()), this->keys.end());
+    }
+
+    std::vector<std::string> PrefixIndex::query(std::string_view prefix, std::size_t limit,
+        const CancelCheck &cancelled) const {
+        std::vector<std::string> found;
+        auto it = std::lower_bound(keys.begin(), keys.end(), prefix,
+            [](const std::string &key, std::string_view p) { return std::string_view(key) < p; });
+        for (; it != keys.end() && found.size() < limit; ++it) {
+            if (it->compare(0, prefix.size(), prefix) != 0)
+                break;
+            if ((found.size() & 0xFF) == 0 && cancelled && cancelled())
+                return {};
+            found.push_back(*it);
+        }
+        return found;
+    }
+
+    struct AutoComplete::Lookup {
+        std::mutex mtx{};
+        std::condition_variable cv{};
+        std::shared_ptr<const PrefixIndex> index;
+        std::string prefix{};
+        std::size_t limit;
+        std::atomic<unsigned> generation{ 0 };
+        unsigned served = 0;
+        bool quit = false;
+        Window *win{};
+        AutoComplete *owner;
+        std::thread worker{};
+
+        Lookup(AutoComplete *owner, std::shared_ptr<const PrefixIndex> &&index, std::size_t limit) :
+            index(std::move(index)), limit(limit), owner(owner) {}
+
+        void request(std::string_view pre, Window *window) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                prefix = pre;
+                win = window;
+                ++generation;
+            }
+            cv.notify_one();
+        }
+
+        void cancel() {
+            std::lock_guard<std::mutex> lock(mtx);
+            served = ++generation;
+        }
+
+        // only the newest request is served, older ones are dropped or aborted mid-scan
+        void run(std::weak_ptr<Lookup> self) {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true) {
+                cv.wait(lock, [this] { return quit || served != generation; });
+                if (quit) return;
+                const unsigned gen = served = generation;
+                const auto idx = index;
+                const std::string pre = prefix;
+                Window *window = win;
+                lock.unlock();
+
+                auto found = idx ? idx->query(pre, limit, [&] { return generation != gen; })
+                    : std::vector<std::string>{};
+                if (window && generation == gen) {
+                    window->post([self, gen, found = std::move(found)]() mutable {
+                        if (auto lk = self.lock(); lk && lk->owner && lk->generation == gen)
+                            lk->owner->showSuggestions(std::move(found));
+                    });
+                }
+                lock.lock();
+            }
+        }
+
+        ~Lookup() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                quit = true;
+                ++generation;
+            }
+            cv.notify_one();
+            if (worker.joinable())
+                worker.join();
+        }
+    };
+
+    AutoComplete::AutoComplete(SDL_Rect rect, const CompColors &colors,
+        std::shared_ptr<const PrefixIndex> index, int numShown,
+        std::size_t maxResults, ExpandDir expDir) :
+        Expandable(rect, "", colors, makePanel(rect, colors, numShown), expDir),
+        input(std::make_unique<TextInput>(rect, colors)),
+        lookup(std::make_shared<Lookup>(this, std::move(index), maxResults)) {
+
+        lookup->worker = std::thread(&Lookup::run, lookup.get(), std::weak_ptr<Lookup>(lookup));
+        input->setChangeCallback([this](const std::string &val) { requestLookup(val); });
+        getList()->setCallback([this](int index, const std::string &) { accept(index); });
+    }
+
+    AutoComplete::~AutoComplete() {
+        lookup->owner = nullptr;
+    }
+
+    std::unique_ptr<ListView> AutoComplete::makePanel(const SDL_Rect &rect, const CompColors &colors, int numShown) {
+        const SDL_Rect panelRect{ 0, 0, rect.w, rect.h * numShown };
+        return std::make_unique<ListView>(panelRect, colors, numShown);
+    }
+
+    void AutoComplete::setIndex(std::shared_ptr<const PrefixIndex> index) {
+        {
+            std::lock_guard<std::mutex> lock(lookup->mtx);
+            lookup->index = std::move(index);
+        }
+        requestLookup(input->value());
+    }
+
+    void AutoComplete::setWindow(Window *window) {
+        Expandable::setWindow(window);
+        input->setWindow(window);
+        input->mapColors(window->graphics());
+    }
+
+    void AutoComplete::translate(int x, int y) {
+        Expandable::translate(x, y);
+        input->translate(x, y);
+    }
+
+    Component *AutoComplete::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown) return nullptr;
+        if (expanded)
+            if (auto found = panel->componentAt(pos, accept))
+                return found;
+        if (auto found = input->componentAt(pos, accept))
+            return found;
+        return Component::componentAt(pos, accept);
+    }
+
+    void AutoComplete::requestLookup(const std::string &prefix) {
+        if (prefix.empty()) {
+            lookup->cancel();
+            setExpanded(false);
+            return;
+        }
+        lookup->request(prefix, win);
+    }
+
+    void AutoComplete::showSuggestions(std::vector<std::string> &&found) {
+        getList()->setItems(std::move(found));
+        setExpanded(input->isActive() && getList()->itemCount() > 0);
+    }
+
+    void AutoComplete::accept(int index) {
+        input->setValue(getList()->item(index));
+        lookup->cancel();
+        setExpanded(false);
+    }
+
+    Component::EventStatus AutoComplete::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (expanded) {
+            if (panel->handleEvent(event)) return HANDLED;
+            if (event.type == SDL_KEYDOWN) {
+                auto list = getList();
+                switch (event.key.keysym.sym) {
+                case SDLK_UP:
+                    list->moveSelection(-1);
+                    return HANDLED;
+                case SDLK_DOWN:
+                    list->moveSelection(1);
+                    return HANDLED;
+                case SDLK_TAB:
+                    accept(std::max(list->selection(), 0));
+                    return HANDLED;
+                case SDLK_RETURN:
+                case SDLK_KP_ENTER:
+                    if (list->selection() >= 0) {
+                        accept(list->selection());
+                        return HANDLED;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        const auto status = input->handleEvent(event);
+        if (expanded && !input->isActive()) {
+            setExpanded(false);
+            return FORWARDED;
+        }
+        return status;
+    }
+
+    void AutoComplete::draw(Graphics &g) {
+        if (!shown) return;
+        input->draw(g);
+        panel->draw(g);
+    }
+
+    Gauge::~Gauge() {
+        if (win && pollId >= 0)
+            win->removePoller(pollId);
+    }
+
+    void Gauge::setWindow(Window *window) {
+        if (win && pollId >= 0)
+            win->removePoller(pollId);
+        Component::setWindow(window);
+        pollId = win->addPoller([this] { return sample() && shown && valueChanged(); });
+    }
+
+    bool Gauge::sample() {
+        if (!source) return false;
+        const double val = source();
+        if (displayKey(val) == displayKey(shownVal))
+            return false;
+        shownVal = val;
+        return true;
+    }
+
+    long long ProgressBar::displayKey(double val) const {
+        const double frac = max > min ? std::clamp((val - min) / (max - min), 0., 1.) : 0.;
+        // filled width in pixels and, when shown, the whole percent
+        const long long px = std::lround(frac * (rect.w - 2));
+        return showText ? px << 8 | (long long)(frac * 100) : px;
+    }
+
+    void ProgressBar::draw(Graphics &g) {
+        if (!shown) return;
+        const double frac = fraction();
+        g.drawRect(rect, 1, colors.bg, colors.line);
+        g.drawRect({ rect.x + 1, rect.y + 1, (int)std::lround(frac * (rect.w - 2)), rect.h - 2 },
+            colors.hl);
+        if (showText) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "%d%%", (int)(frac * 100));
+            g.drawString(rect, buf, win->font(), colors.text);
+        }
+    }
+
+    long long ValueLabel::displayKey(double val) const {
+        return std::llround(val * std::pow(10., precision));
+    }
+
+    void ValueLabel::draw(Graphics &g) {
+        if (!shown) return;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*f%s", precision, shownVal, suffix.c_str());
+        g.drawString(rect, buf, win->font(), colors.text);
+    }
+
+    void NumericLabel::setValue(double val) {
+        if (displayKey(val) == displayKey(shownVal)) return;
+        shownVal = val;
+        if (win && shown && valueChanged())
+            win->invalidate();
+    }
+
+    long long NumericLabel::displayKey(double val) const {
+        return std::llround(val * std::pow(10., precision));
+    }
+
+    void NumericLabel::format() {
+        const auto res = precision > 0
+            ? std::to_chars(buf, buf + capacity, shownVal, std::chars_format::fixed, precision)
+            : std::to_chars(buf, buf + capacity, std::llround(shownVal));
+        len = res.ec == std::errc{} ? int(res.ptr - buf) : 0;
+    }
+
+    SDL_Rect NumericLabel::cellRect(int fromRight) const {
+        return { rect.x + rect.w - (fromRight + 1) * cellW, rect.y, cellW, rect.h };
+    }
+
+    bool NumericLabel::valueChanged() {
+        format();
+        if (!cellW || !win) return true;
+        SDL_Rect dmg{};
+        for (int i = 0; i < std::max(len, drawnLen); ++i) {
+            const char now = i < len ? buf[len - 1 - i] : 0;
+            const char was = i < drawnLen ? drawn[drawnLen - 1 - i] : 0;
+            if (now == was) continue;
+            const SDL_Rect cell = cellRect(i);
+            if (SDL_RectEmpty(&dmg))
+                dmg = cell;
+            else
+                SDL_UnionRect(&dmg, &cell, &dmg);
+        }
+        if (!SDL_RectEmpty(&dmg))
+            win->invalidate(dmg);
+        return false;
+    }
+
+    void NumericLabel::draw(Graphics &g) {
+        if (!shown) return;
+        format();
+        if (!cellW) {
+            // widest of the characters a number can contain, so digits never shift
+            for (char ch : std::string_view("0123456789-.e+")) {
+                int adv = 0;
+                TTF_GlyphMetrics(win->font(), ch, nullptr, nullptr, nullptr, nullptr, &adv);
+                cellW = std::max(cellW, adv);
+            }
+        }
+        for (int i = 0; i < len; ++i) {
+            SDL_Surface *gl = g.glyph(win->font(), buf[len - 1 - i], colors.text);
+            if (!gl) continue;
+            SDL_Rect cell = cellRect(i);
+            cell.x += (cellW - gl->w) / 2;
+            cell.y += (rect.h - gl->h) / 2;
+            SDL_BlitSurface(gl, NULL, g.screen, &cell);
+        }
+        std::memcpy(drawn, buf, len);
+        drawnLen = len;
+    }
+
+    Colormap::Colormap() {
+        for (Uint32 i = 0; i < 256; ++i)
+            lut[i] = 0xFF000000 | i << 16 | i << 8 | i;
+    }
+
+    Colormap Colormap::gradient(std::initializer_list<int> stops) {
+        Colormap map;
+        const int n = (int)stops.size();
+        if (n == 0) return map;
+        const int *s = stops.begin();
+        for (int i = 0; i < 256; ++i) {
+            const float pos = n > 1 ? i / 255.f * (n - 1) : 0.f;
+            const int k = std::min((int)pos, n - 2 < 0 ? 0 : n - 2);
+            const float t = n > 1 ? pos - k : 0.f;
+            const int a = s[k], b = s[std::min(k + 1, n - 1)];
+            Uint32 px = 0xFF000000;
+            for (int sh = 0; sh <= 16; sh += 8) {
+                const float ca = float((a >> sh) & 0xFF), cb = float((b >> sh) & 0xFF);
+                px |= Uint32(std::lround(ca + (cb - ca) * t)) << sh;
+            }
+            map.lut[i] = px;
+        }
+        return map;
+    }
+
+    // value -> LUT index for one row, NaN maps to 0
+    static void colormapRow(const float *src, Uint32 *dst, int n,
+        float lo, float scale, const Uint32 *lut) {
+        int x = 0;
+#ifdef SDLW_SSE2
+        const __m128 vlo = _mm_set1_ps(lo), vscale = _mm_set1_ps(scale);
+        const __m128 vzero = _mm_setzero_ps(), vmax = _mm_set1_ps(255.f);
+        alignas(16) int idx[4];
+        for (; x + 4 <= n; x += 4) {
+            __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(src + x), vlo), vscale);
+            v = _mm_min_ps(_mm_max_ps(v, vzero), vmax);
+            _mm_store_si128((__m128i *)idx, _mm_cvttps_epi32(v));
+            dst[x] = lut[idx[0]];
+            dst[x + 1] = lut[idx[1]];
+            dst[x + 2] = lut[idx[2]];
+            dst[x + 3] = lut[idx[3]];
+        }
+#endif
+        for (; x < n; ++x) {
+            const float v = (src[x] - lo) * scale;
+            dst[x] = lut[!(v > 0.f) ? 0 : (v < 255.f ? (int)v : 255)];
+        }
+    }
+
+    static void colormapRow(const Uint16 *src, Uint32 *dst, int n,
+        float lo, float scale, const Uint32 *lut) {
+        for (int x = 0; x < n; ++x) {
+            const float v = (src[x] - lo) * scale;
+            dst[x] = lut[!(v > 0.f) ? 0 : (v < 255.f ? (int)v : 255)];
+        }
+    }
+
+    static Uint32 lerpPixel(Uint32 a, Uint32 b, Uint32 t) {
+        const Uint32 rb = ((a & 0xFF00FF) * (256 - t) + (b & 0xFF00FF) * t) >> 8 & 0xFF00FF;
+        const Uint32 g = ((a & 0x00FF00) * (256 - t) + (b & 0x00FF00) * t) >> 8 & 0x00FF00;
+        return 0xFF000000 | rb | g;
+    }
+
+    Heatmap::Heatmap(SDL_Rect rect, int cols, int rows, const Colormap &cmap,
+        float lo, float hi, Filter filter) :
+        Component(rect, {}), cols(cols), rows(rows), lo(lo), hi(hi), cmap(cmap), filter(filter) {
+        cells = SDL_CreateRGBSurfaceWithFormat(0, cols, rows, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (cells) {
+            SDL_SetSurfaceBlendMode(cells, SDL_BLENDMODE_NONE);
+            SDL_FillRect(cells, NULL, cmap[0]);
+        }
+        setFilter(filter);
+    }
+
+    Heatmap::~Heatmap() {
+        SDL_FreeSurface(cells);
+        SDL_FreeSurface(scaled);
+    }
+
+    void Heatmap::setFilter(Filter f) {
+        filter = f;
+        if (filter == Filter::BILINEAR && !scaled) {
+            scaled = SDL_CreateRGBSurfaceWithFormat(0, rect.w, rect.h, 32, SDL_PIXELFORMAT_ARGB8888);
+            if (scaled)
+                SDL_SetSurfaceBlendMode(scaled, SDL_BLENDMODE_NONE);
+        }
+        resample(0, rows);
+        if (win) win->invalidate(rect);
+    }
+
+    void Heatmap::setData(const float *data, std::ptrdiff_t stride) {
+        updateRows(data, stride, 0, rows);
+    }
+
+    void Heatmap::setData(const Uint16 *data, std::ptrdiff_t stride) {
+        updateRows(data, stride, 0, rows);
+    }
+
+    void Heatmap::updateRows(const float *data, std::ptrdiff_t stride, int firstRow, int count) {
+        convert(data, stride, firstRow, count);
+    }
+
+    void Heatmap::updateRows(const Uint16 *data, std::ptrdiff_t stride, int firstRow, int count) {
+        convert(data, stride, firstRow, count);
+    }
+
+    template <typename T>
+    void Heatmap::convert(const T *data, std::ptrdiff_t stride, int firstRow, int count) {
+        count = std::min(count, rows - firstRow);
+        if (!cells || firstRow < 0 || count <= 0) return;
+        const float scale = hi > lo ? 256.f / (hi - lo) : 0.f;
+        auto work = [=](int from, int to) {
+            for (int r = from; r < to; ++r) {
+                auto dst = (Uint32 *)((Uint8 *)cells->pixels + 1LL * (firstRow + r) * cells->pitch);
+                colormapRow(data + r * stride, dst, cols, lo, scale, cmap.data());
+            }
+        };
+
+        // small updates are not worth a thread start
+        const int n = std::min(threads, 1LL * count * cols < (1 << 16) ? 1 : count);
+        std::vector<std::thread> pool;
+        for (int i = 1; i < n; ++i)
+            pool.emplace_back(work, count * i / n, count * (i + 1) / n);
+        work(0, count / n);
+        for (auto &t : pool)
+            t.join();
+
+        resample(firstRow, count);
+        if (win) win->invalidate(screenRows(firstRow, count));
+    }
+
+    void Heatmap::resample(int firstRow, int count) {
+        if (filter != Filter::BILINEAR || !scaled || !cells) return;
+        const SDL_Rect dst = screenRows(firstRow, count);
+        const int y0 = dst.y - rect.y, y1 = y0 + dst.h;
+        const float fx = 1.f * cols / rect.w, fy = 1.f * rows / rect.h;
+
+        for (int y = y0; y < y1; ++y) {
+            const float sy = std::clamp((y + .5f) * fy - .5f, 0.f, rows - 1.f);
+            const int r0 = (int)sy, r1 = std::min(r0 + 1, rows - 1);
+            const Uint32 ty = Uint32((sy - r0) * 256);
+            auto row0 = (const Uint32 *)((const Uint8 *)cells->pixels + 1LL * r0 * cells->pitch);
+            auto row1 = (const Uint32 *)((const Uint8 *)cells->pixels + 1LL * r1 * cells->pitch);
+            auto out = (Uint32 *)((Uint8 *)scaled->pixels + 1LL * y * scaled->pitch);
+            for (int x = 0; x < rect.w; ++x) {
+                const float sx = std::clamp((x + .5f) * fx - .5f, 0.f, cols - 1.f);
+                const int c0 = (int)sx, c1 = std::min(c0 + 1, cols - 1);
+                const Uint32 tx = Uint32((sx - c0) * 256);
+                out[x] = lerpPixel(lerpPixel(row0[c0], row0[c1], tx),
+                    lerpPixel(row1[c0], row1[c1], tx), ty);
+            }
+        }
+    }
+
+    // screen area affected by a range of data rows, one row of margin for filtering
+    SDL_Rect Heatmap::screenRows(int firstRow, int count) const {
+        const float fy = 1.f * rect.h / rows;
+        const int y0 = std::max(0, (int)std::floor((firstRow - 1) * fy));
+        const int y1 = std::min(rect.h, (int)std::ceil((firstRow + count + 1) * fy));
+        return { rect.x, rect.y + y0, rect.w, y1 - y0 };
+    }
+
+    void Heatmap::draw(Graphics &g) {
+        if (!shown || !cells) return;
+        SDL_Rect dst = rect;
+        if (filter == Filter::BILINEAR && scaled)
+            SDL_BlitSurface(scaled, NULL, g.screen, &dst);
+        else
+            SDL_BlitScaled(cells, NULL, g.screen, &dst);
+    }
+
+    Waterfall::Waterfall(SDL_Rect rect, int cols, int history, const Colormap &cmap,
+        float lo, float hi, bool newestOnTop) :
+        Component(rect, {}), cols(cols), history(history),
+        lo(lo), hi(hi), newestOnTop(newestOnTop), cmap(cmap) {
+        ring = SDL_CreateRGBSurfaceWithFormat(0, cols, history, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (ring)
+            SDL_SetSurfaceBlendMode(ring, SDL_BLENDMODE_NONE);
+        clear();
+    }
+
+    Waterfall::~Waterfall() {
+        SDL_FreeSurface(ring);
+    }
+
+    void Waterfall::clear() {
+        if (ring) SDL_FillRect(ring, NULL, cmap[0]);
+        head = 0;
+        if (win) win->invalidate(rect);
+    }
+
+    void Waterfall::appendRow(const float *data) { append(data); }
+    void Waterfall::appendRow(const Uint16 *data) { append(data); }
+
+    template <typename T>
+    void Waterfall::append(const T *data) {
+        if (!ring) return;
+        // rows are always shown from head to the end, then from the start to head
+        int row = head;
+        if (newestOnTop)
+            row = head = (head + history - 1) % history;
+        else
+            head = (head + 1) % history;
+        auto dst = (Uint32 *)((Uint8 *)ring->pixels + 1LL * row * ring->pitch);
+        colormapRow(data, dst, cols, lo, hi > lo ? 256.f / (hi - lo) : 0.f, cmap.data());
+        if (win) win->invalidate(rect);
+    }
+
+    void Waterfall::draw(Graphics &g) {
+        if (!shown || !ring) return;
+        const int split = (int)std::lround(1. * (history - head) * rect.h / history);
+        SDL_Rect srcA{ 0, head, cols, history - head }, srcB{ 0, 0, cols, head };
+        SDL_Rect dstA{ rect.x, rect.y, rect.w, split };
+        SDL_Rect dstB{ rect.x, rect.y + split, rect.w, rect.h - split };
+        const bool unscaled = cols == rect.w && history == rect.h;
+        if (srcA.h > 0)
+            unscaled ? SDL_BlitSurface(ring, &srcA, g.screen, &dstA)
+                : SDL_BlitScaled(ring, &srcA, g.screen, &dstA);
+        if (srcB.h > 0)
+            unscaled ? SDL_BlitSurface(ring, &srcB, g.screen, &dstB)
+                : SDL_BlitScaled(ring, &srcB, g.screen, &dstB);
+    }
+
+    Canvas::Canvas(SDL_Rect rect, int bgcolor) : Component(rect, { bgcolor }) {
+        backing = SDL_CreateRGBSurface(0, rect.w, rect.h, 32,
+            0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+        if (backing) {
+            SDL_SetSurfaceBlendMode(backing, SDL_BLENDMODE_NONE);
+            painter = Painter(backing);
+            painter.fill(painter.color(bgcolor));
+        }
+    }
+
+    Canvas::~Canvas() {
+        SDL_FreeSurface(backing);
+    }
+
+    void Canvas::setWindow(Window *window) {
+        Component::setWindow(window);
+        repaint();
+    }
+
+    void Canvas::repaint() {
+        if (!backing) return;
+        painter.fill(painter.color(rawColors.bg));
+        if (onPaint)
+            onPaint(painter);
+        markDirty();
+    }
+
+    void Canvas::markDirty(const SDL_Rect &region) {
+        if (win)
+            win->invalidate(region + SDL_Point{ rect.x, rect.y });
+    }
+
+    void Canvas::draw(Graphics &g) {
+        if (!shown || !backing) return;
+        SDL_Rect dst = rect;
+        SDL_BlitSurface(backing, NULL, g.screen, &dst);
+    }
+
+    void BoxItem::draw(Painter &p, const SceneView &view) {
+        const SDL_Rect r = view.toScreen(box);
+        if (r.w < 3 && r.h < 3) {
+            p.drawRect(r, p.color(color));
+            return;
+        }
+        p.drawRect(r, 1, p.color(color), p.color(textColor));
+        if (font && !label.empty() && r.h >= TTF_FontHeight(font) && r.w >= TTF_FontHeight(font))
+            p.drawString(r, label, font, p.color(textColor));
+    }
+
+    SceneCanvas::SceneCanvas(SDL_Rect rect, int bgcolor, float cellSize) :
+        Component(rect, { bgcolor }), cellSize(cellSize) {
+        view.viewport = rect;
+    }
+
+    SceneCanvas::Cells SceneCanvas::cellsOf(const SceneBounds &b) const {
+        return {
+            SceneView::pixel(b.x / cellSize), SceneView::pixel(b.y / cellSize),
+            SceneView::pixel((b.x + b.w) / cellSize), SceneView::pixel((b.y + b.h) / cellSize)
+        };
+    }
+
+    void SceneCanvas::insertCells(int index) {
+        const Cells c = cellsOf(items[index]->bounds());
+        if (1LL * (c.x1 - c.x0 + 1) * (c.y1 - c.y0 + 1) > maxCells) {
+            // an empty range, removeCells finds it in oversized instead
+            itemCells[index] = { 0, 0, -1, -1 };
+            oversized.push_back(index);
+            return;
+        }
+        itemCells[index] = c;
+        for (int cy = c.y0; cy <= c.y1; ++cy)
+            for (int cx = c.x0; cx <= c.x1; ++cx)
+                grid[key(cx, cy)].push_back(index);
+    }
+
+    void SceneCanvas::removeCells(int index) {
+        oversized.erase(std::remove(oversized.begin(), oversized.end(), index), oversized.end());
+        const Cells c = itemCells[index];
+        for (int cy = c.y0; cy <= c.y1; ++cy) {
+            for (int cx = c.x0; cx <= c.x1; ++cx) {
+                auto it = grid.find(key(cx, cy));
+                if (it == grid.end()) continue;
+                auto &cell = it->second;
+                cell.erase(std::remove(cell.begin(), cell.end(), index), cell.end());
+                if (cell.empty())
+                    grid.erase(it);
+            }
+        }
+    }
+
+    int SceneCanvas::addItem(std::unique_ptr<SceneItem> &&item) {
+        items.push_back(std::move(item));
+        itemCells.push_back({});
+        seenStamp.push_back(0);
+        const int index = (int)items.size() - 1;
+        insertCells(index);
+        if (win) win->invalidate(rect);
+        return index;
+    }
+
+    void SceneCanvas::removeItem(int index) {
+        const int last = (int)items.size() - 1;
+        removeCells(index);
+        if (index != last) {
+            removeCells(last);
+            items[index] = std::move(items[last]);
+            insertCells(index);
+        }
+        items.pop_back();
+        itemCells.pop_back();
+        seenStamp.pop_back();
+        if (win) win->invalidate(rect);
+    }
+
+    void SceneCanvas::itemMoved(int index) {
+        removeCells(index);
+        insertCells(index);
+        if (win) win->invalidate(rect);
+    }
+
+    void SceneCanvas::clearItems() {
+        items.clear();
+        itemCells.clear();
+        seenStamp.clear();
+        oversized.clear();
+        grid.clear();
+        if (win) win->invalidate(rect);
+    }
+
+    void SceneCanvas::setView(float x, float y, float scale) {
+        view.x = x;
+        view.y = y;
+        view.scale = std::clamp(scale, minScale, maxScale);
+        if (win) win->invalidate(rect);
+    }
+
+    void SceneCanvas::panBy(int dx, int dy) {
+        setView(view.x - dx / view.scale, view.y - dy / view.scale, view.scale);
+    }
+
+    void SceneCanvas::zoomAt(SDL_Point screenPos, float factor) {
+        // keep the world point under the cursor in place
+        const float wx = view.x + (screenPos.x - rect.x) / view.scale;
+        const float wy = view.y + (screenPos.y - rect.y) / view.scale;
+        const float scale = std::clamp(view.scale * factor, minScale, maxScale);
+        setView(wx - (screenPos.x - rect.x) / scale, wy - (screenPos.y - rect.y) / scale, scale);
+    }
+
+    void SceneCanvas::fitAll() {
+        if (items.empty()) return;
+        constexpr float inf = std::numeric_limits<float>::max();
+        float left = inf, top = inf, right = -inf, bottom = -inf;
+        for (const auto &item : items) {
+            const SceneBounds b = item->bounds();
+            left = std::min(left, b.x);
+            top = std::min(top, b.y);
+            right = std::max(right, b.x + b.w);
+            bottom = std::max(bottom, b.y + b.h);
+        }
+        const float scale = std::min(rect.w / std::max(right - left, 1e-6f),
+            rect.h / std::max(bottom - top, 1e-6f));
+        setView(left, top, scale);
+    }
+
+    void SceneCanvas::translate(int x, int y) {
+        Component::translate(x, y);
+        view.viewport = rect;
+    }
+
+    Component::EventStatus SceneCanvas::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        switch (event.type) {
+        case SDL_MOUSEWHEEL: {
+            SDL_Point p;
+            SDL_GetMouseState(&p.x, &p.y);
+            if (!posInside(p)) return IGNORED;
+            zoomAt(p, event.wheel.y > 0 ? 1.25f : 0.8f);
+            return FORWARDED;
+        }
+        case SDL_MOUSEBUTTONDOWN:
+            if (!thisWasClicked(event)) return IGNORED;
+            panning = true;
+            mousePos = { event.button.x, event.button.y };
+            return HANDLED;
+        case SDL_MOUSEMOTION:
+            if (!panning) return IGNORED;
+            panBy(event.motion.x - mousePos.x, event.motion.y - mousePos.y);
+            mousePos = { event.motion.x, event.motion.y };
+            return FORWARDED;
+        case SDL_MOUSEBUTTONUP:
+            panning = false;
+            return IGNORED;
+        default:
+            return IGNORED;
+        }
+    }
+
+    void SceneCanvas::draw(Graphics &g) {
+        if (!shown) return;
+        SDL_Rect oldClip, clip;
+        SDL_GetClipRect(g.screen, &oldClip);
+        if (!SDL_IntersectRect(&oldClip, &rect, &clip)) return;
+        SDL_SetClipRect(g.screen, &clip);
+        g.drawRect(rect, colors.bg);
+        forEachVisible([&](int, SceneItem &item) {
+            if (cullSize > 0.f) {
+                const SceneBounds b = item.bounds();
+                if (b.w * view.scale < cullSize && b.h * view.scale < cullSize)
+                    return;
+            }
+            item.draw(g, view);
+        });
+        SDL_SetClipRect(g.screen, &oldClip);
+    }
+
+    RangeSlider::RangeSlider(SDL_Rect rect, int min, int max, int step,
+        const CompColors &colors, int histHeight, int thumbW) :
+        Component(rect, colors),
+        lower(rect, min, max, step, colors, false, thumbW),
+        upper(rect, min, max, step, colors, false, thumbW),
+        min(min), max(max), histH(histHeight), lastLo(min), lastHi(max) {
+        upper.setVal(max);
+    }
+
+    RangeSlider::~RangeSlider() {
+        stopWorker();
+        SDL_FreeSurface(histo);
+    }
+
+    void RangeSlider::setRange(int lo, int hi) {
+        lower.setVal(std::min(lo, hi));
+        upper.setVal(std::max(lo, hi));
+        lastLo = lower.trueVal();
+        lastHi = upper.trueVal();
+        if (win) win->invalidate();
+    }
+
+    void RangeSlider::translate(int x, int y) {
+        Component::translate(x, y);
+        lower.translate(x, y);
+        upper.translate(x, y);
+    }
+
+    void RangeSlider::setWindow(Window *window) {
+        Component::setWindow(window);
+        for (Slider *s : { &lower, &upper }) {
+            s->setWindow(window);
+            s->mapColors(window->graphics());
+        }
+        if (pendingData)
+            startHistogram();
+    }
+
+    void RangeSlider::setHistogram(std::shared_ptr<const std::vector<float>> data, int bins) {
+        pendingData = std::move(data);
+        pendingBins = bins;
+        if (win)
+            startHistogram();
+    }
+
+    void RangeSlider::stopWorker() {
+        if (cancelJob)
+            *cancelJob = true;
+        if (worker.joinable())
+            worker.join();
+    }
+
+    void RangeSlider::startHistogram() {
+        stopWorker();
+        if (histH <= 0 || pendingBins <= 0) return;
+        cancelJob = std::make_shared<std::atomic<bool>>(false);
+        worker = std::thread([data = std::move(pendingData), bins = pendingBins,
+            lo = float(min), hi = float(max), cancel = cancelJob, window = win, this] {
+            std::vector<unsigned> counts(bins);
+            const float scale = hi > lo ? bins / (hi - lo) : 0.f;
+            for (std::size_t i = 0; i < data->size(); ++i) {
+                if ((i & 0xFFFF) == 0 && *cancel) return;
+                const float v = ((*data)[i] - lo) * scale;
+                if (v >= 0.f && v <= bins)
+                    ++counts[std::min((int)v, bins - 1)];
+            }
+            // cancel is only set on the UI thread, by a newer job or the destructor
+            window->post([this, cancel, counts = std::move(counts)] {
+                if (!*cancel) buildHistogram(counts);
+            });
+        });
+        pendingData = nullptr;
+    }
+
+    void RangeSlider::buildHistogram(const std::vector<unsigned> &counts) {
+        const SDL_Rect hr = histRect();
+        SDL_FreeSurface(histo);
+        histo = SDL_CreateRGBSurface(0, hr.w, hr.h, 32,
+            0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+        if (!histo) return;
+
+        Painter p(histo);
+        p.fill(colors.bg);
+        const unsigned peak = std::max(1u, *std::max_element(counts.begin(), counts.end()));
+        const int n = (int)counts.size();
+        for (int i = 0; i < n; ++i) {
+            const int x0 = i * hr.w / n, x1 = (i + 1) * hr.w / n;
+            const int bh = (int)(1LL * counts[i] * hr.h / peak);
+            p.drawRect({ x0, hr.h - bh, std::max(1, x1 - x0 - 1), bh }, colors.extra2);
+        }
+        win->invalidate(hr);
+    }
+
+    SDL_Rect RangeSlider::labelRect(const Slider &s) const {
+        const SDL_Rect t = s.thumbRect();
+        const int fh = win ? TTF_FontHeight(win->font()) : 16;
+        return { t.x + t.w / 2 - 30, t.y + t.h, 60, fh };
+    }
+
+    SDL_Rect RangeSlider::damageOf(const Slider &s) const {
+        const SDL_Rect t = s.thumbRect(), l = labelRect(s);
+        SDL_Rect u;
+        SDL_UnionRect(&t, &l, &u);
+        return u;
+    }
+
+    Component::EventStatus RangeSlider::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        const SDL_Rect before[] = { damageOf(lower), damageOf(upper), bandRect() };
+
+        // overlapping thumbs go to upper, unless it sits at max and could only be pushed back
+        const bool lowerFirst = upper.trueVal() >= max;
+        Slider &first = lowerFirst ? lower : upper, &second = lowerFirst ? upper : lower;
+        EventStatus st = first.handleEvent(event);
+        if (event.type != SDL_MOUSEBUTTONDOWN || st != HANDLED)
+            st = std::max(st, second.handleEvent(event));
+        if (!st) return IGNORED;
+
+        if (lower.trueVal() > upper.trueVal()) {
+            if (lower.isDragging())
+                lower.setVal(upper.trueVal());
+            else
+                upper.setVal(lower.trueVal());
+        }
+        const int lo = lower.trueVal(), hi = upper.trueVal();
+        if ((lo != lastLo || hi != lastHi) && onChange)
+            onChange(lo, hi);
+        lastLo = lo;
+        lastHi = hi;
+
+        if (!win) return st;
+        // only the thumbs, their labels and the band along the track change
+        win->invalidate(before[0]);
+        win->invalidate(before[1]);
+        win->invalidate(before[2]);
+        win->invalidate(damageOf(lower));
+        win->invalidate(damageOf(upper));
+        win->invalidate(bandRect());
+        return st == FORWARDED ? FORWARDED : HANDLED_PARTIAL;
+    }
+
+    void RangeSlider::draw(Graphics &g) {
+        if (!shown) return;
+        if (histo) {
+            SDL_Rect hr = histRect();
+            SDL_BlitSurface(histo, NULL, g.screen, &hr);
+        }
+        g.drawRect(rect, 1, colors.extra1, colors.line);
+        g.drawRect(bandRect(), colors.hl);
+        lower.drawThumb(g);
+        upper.drawThumb(g);
+        g.drawString(labelRect(lower), lower.str(), win->font(), colors.text);
+        g.drawString(labelRect(upper), upper.str(), win->font(), colors.text);
+    }
+
+    Tabs::~Tabs() {
+        if (win && pollId >= 0)
+            win->removePoller(pollId);
+    }
+
+    int Tabs::addPage(std::string_view title, PageFactory &&factory) {
+        pages.push_back({ std::string(title), std::move(factory) });
+        if (active < 0)
+            setActive(0);
+        else if (win)
+            win->invalidate();
+        return (int)pages.size() - 1;
+    }
+
+    void Tabs::setActive(int index) {
+        if (index < 0 || index >= (int)pages.size()) return;
+        if (active >= 0 && active < (int)pages.size())
+            pages[active].lastActive = SDL_GetTicks();
+        active = index;
+        Page &p = pages[index];
+        if (!p.panel && win) {
+            p.panel = p.factory(pageRect());
+            if (p.panel) {
+                p.panel->setWindow(win);
+                p.panel->mapColors(win->graphics());
+            }
+        }
+        if (win) win->invalidate();
+    }
+
+    void Tabs::translate(int x, int y) {
+        Component::translate(x, y);
+        for (auto &p : pages)
+            if (p.panel) p.panel->translate(x, y);
+    }
+
+    Component *Tabs::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown || !posInside(pos)) return nullptr;
+        if (active >= 0 && pages[active].panel)
+            if (auto found = pages[active].panel->componentAt(pos, accept))
+                return found;
+        return accept(*this) ? this : nullptr;
+    }
+
+    void Tabs::setWindow(Window *window) {
+        Component::setWindow(window);
+        for (auto &p : pages)
+            if (p.panel) p.panel->setWindow(window);
+        if (pollId < 0)
+            pollId = win->addPoller([this] { unloadIdle(); return false; });
+        if (active >= 0)
+            setActive(active);
+    }
+
+    void Tabs::unloadIdle() {
+        if (!unloadAfter) return;
+        const Uint32 now = SDL_GetTicks();
+        // no need to look more often than once a second
+        if (now - lastSweep < 1000) return;
+        lastSweep = now;
+        for (int i = 0; i < (int)pages.size(); ++i) {
+            Page &p = pages[i];
+            if (i != active && p.panel && now - p.lastActive >= unloadAfter)
+                p.panel.reset();
+        }
+    }
+
+    SDL_Rect Tabs::tabRect(int index) const {
+        const int n = (int)pages.size();
+        const int x0 = rect.w * index / n, x1 = rect.w * (index + 1) / n;
+        return { rect.x + x0, rect.y, x1 - x0, tabH };
+    }
+
+    Component::EventStatus Tabs::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (thisWasClicked(event) && event.button.y < rect.y + tabH) {
+            for (int i = 0; i < (int)pages.size(); ++i) {
+                const SDL_Rect r = tabRect(i);
+                const SDL_Point p{ event.button.x, event.button.y };
+                if (SDL_PointInRect(&p, &r)) {
+                    if (i != active)
+                        setActive(i);
+                    return HANDLED;
+                }
             }
         }
-        if (input->handleEvent(event))
+        if (active >= 0 && pages[active].panel)
+            return pages[active].panel->handleEvent(event);
+        return IGNORED;
+    }
+
+    void Tabs::draw(Graphics &g) {
+        if (!shown) return;
+        for (int i = 0; i < (int)pages.size(); ++i) {
+            const SDL_Rect r = tabRect(i);
+            g.drawRect(r, 1, i == active ? colors.hl : colors.bg, colors.line);
+            g.drawString(r, pages[i].title, win->font(), colors.text);
+        }
+        if (active >= 0 && pages[active].panel)
+            pages[active].panel->draw(g);
+        else
+            g.drawRect(pageRect(), 1, colors.bg, colors.line);
+    }
+
+    Splitter::Splitter(SDL_Rect rect, const CompColors &colors, bool horizontal, int dividerW) :
+        Component(rect, colors), horizontal(horizontal),
+        split(((horizontal ? rect.w : rect.h) - dividerW) / 2), dividerW(dividerW) {}
+
+    Splitter::~Splitter() {
+        dropSnapshots();
+    }
+
+    Component *Splitter::setPane(int index, std::unique_ptr<Component> &&comp) {
+        panes[index] = std::move(comp);
+        if (win) {
+            panes[index]->setWindow(win);
+            panes[index]->mapColors(win->graphics());
+        }
+        relayout();
+        return panes[index].get();
+    }
+
+    void Splitter::setSplit(int px) {
+        const int extent = (horizontal ? rect.w : rect.h) - dividerW;
+        split = std::clamp(px, std::min(minPane, extent / 2), std::max(extent - minPane, extent / 2));
+        relayout();
+    }
+
+    SDL_Rect Splitter::paneRect(int index) const {
+        if (horizontal) {
+            return index == 0 ? SDL_Rect{ rect.x, rect.y, split, rect.h }
+                : SDL_Rect{ rect.x + split + dividerW, rect.y, rect.w - split - dividerW, rect.h };
+        }
+        return index == 0 ? SDL_Rect{ rect.x, rect.y, rect.w, split }
+            : SDL_Rect{ rect.x, rect.y + split + dividerW, rect.w, rect.h - split - dividerW };
+    }
+
+    SDL_Rect Splitter::dividerRect() const {
+        return horizontal ? SDL_Rect{ rect.x + split, rect.y, dividerW, rect.h }
+            : SDL_Rect{ rect.x, rect.y + split, rect.w, dividerW };
+    }
+
+    void Splitter::relayout() {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < 2; ++i) {
+            if (!panes[i]) continue;
+            const SDL_Rect r = paneRect(i);
+            if (layout) {
+                layout(i, *panes[i], r);
+            }
+            else {
+                panes[i]->setPos(r.x, r.y);
+                panes[i]->setDims(r.w, r.h);
+            }
+        }
+        layoutMs = elapsedMs(start);
+        relaidOut = true;
+        if (win) win->invalidate();
+    }
+
+    void Splitter::snapshot() {
+        dropSnapshots();
+        SDL_Surface *screen = win->graphics().screen;
+        for (int i = 0; i < 2; ++i) {
+            SDL_Rect r = paneRect(i);
+            snaps[i] = SDL_CreateRGBSurface(0, r.w, r.h, 32,
+                0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+            if (snaps[i]) {
+                SDL_SetSurfaceBlendMode(snaps[i], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(screen, &r, snaps[i], NULL);
+            }
+        }
+    }
+
+    void Splitter::dropSnapshots() {
+        for (auto &s : snaps) {
+            SDL_FreeSurface(s);
+            s = nullptr;
+        }
+    }
+
+    void Splitter::translate(int x, int y) {
+        Component::translate(x, y);
+        for (auto &p : panes)
+            if (p) p->translate(x, y);
+    }
+
+    Component *Splitter::componentAt(SDL_Point pos, bool (*accept)(const Component &)) {
+        if (!shown || !posInside(pos)) return nullptr;
+        for (auto &p : panes)
+            if (p)
+                if (auto found = p->componentAt(pos, accept))
+                    return found;
+        return accept(*this) ? this : nullptr;
+    }
+
+    void Splitter::setWindow(Window *window) {
+        Component::setWindow(window);
+        for (auto &p : panes) {
+            if (!p) continue;
+            p->setWindow(window);
+            p->mapColors(window->graphics());
+        }
+    }
+
+    Component::EventStatus Splitter::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        const SDL_Rect div = dividerRect();
+        switch (event.type) {
+        case SDL_MOUSEBUTTONDOWN: {
+            const SDL_Point p{ event.button.x, event.button.y };
+            if (!SDL_PointInRect(&p, &div)) break;
+            dragging = true;
+            cached = budgetMs <= 0. || lastCostMs > budgetMs;
+            if (cached && win)
+                snapshot();
             return HANDLED;
-        return Expandable::handleEvent(event);
+        }
+        case SDL_MOUSEMOTION:
+            if (!dragging) break;
+            if (!cached && lastCostMs > budgetMs && win) {
+                // the screen still holds the last full layout
+                cached = true;
+                snapshot();
+            }
+            split = horizontal ? event.motion.x - rect.x - dividerW / 2
+                : event.motion.y - rect.y - dividerW / 2;
+            if (cached) {
+                const int extent = (horizontal ? rect.w : rect.h) - dividerW;
+                split = std::clamp(split, std::min(minPane, extent / 2), std::max(extent - minPane, extent / 2));
+                if (win) win->invalidate();
+            }
+            else {
+                setSplit(split);
+            }
+            return HANDLED;
+        case SDL_MOUSEBUTTONUP:
+            if (!dragging) break;
+            dragging = false;
+            if (cached) {
+                dropSnapshots();
+                cached = false;
+                setSplit(split);
+            }
+            return HANDLED;
+        default:
+            break;
+        }
+        if (dragging) return IGNORED;
+        for (auto &p : panes)
+            if (p)
+                if (auto st = p->handleEvent(event))
+                    return st;
+        return IGNORED;
     }
 
-    void ColorSelect::draw(Graphics &g) {
+    void Splitter::draw(Graphics &g) {
         if (!shown) return;
-        Color cur = g.color(color());
-        text = std::string{ '#' } + str();
-        g.drawRect(rect, 1, hovered ? colors.hl : colors.bg, colors.line);
-        g.drawString(rect, text, win->font(), colors.text);
-        g.drawRect({rect.x + 10, rect.y + 10, 20, 20}, 1, cur, colors.line);
-        if (expanded) {
-            panel->draw(g);
-            g.drawRect({ panel->x() + 20, panel->y() + 20, 30, 100 }, 1, cur, colors.line);
+        if (dragging && cached) {
+            for (int i = 0; i < 2; ++i) {
+                SDL_Rect r = paneRect(i);
+                if (snaps[i])
+                    SDL_BlitScaled(snaps[i], NULL, g.screen, &r);
+            }
         }
-        input->draw(g);
+        else {
+            const Uint64 start = SDL_GetPerformanceCounter();
+            for (auto &p : panes)
+                if (p) p->draw(g);
+            if (relaidOut) {
+                lastCostMs = layoutMs + elapsedMs(start);
+                relaidOut = false;
+            }
+        }
+        g.drawRect(dividerRect(), 1, dragging ? colors.hl : colors.bg, colors.line);
     }
-    
-    void TextInput::activate() {
-        active = true;
-        SDL_StartTextInput();
-        if (autoHide)
-            show();
+
+    struct FilePicker::Worker {
+        struct Entry {
+            std::string name, lower;
+            std::uintmax_t size = 0;
+            long long mtime = 0;
+            bool dir = false, parent = false;
+        };
+        struct Scan {
+            std::thread thread{};
+            // set as the thread returns, so it can be joined without waiting
+            std::shared_ptr<std::atomic<bool>> finished{};
+        };
+        static constexpr std::size_t batchSize = 4096;
+        static constexpr Uint32 batchMs = 30, publishMs = 100;
+
+        std::mutex mtx{};
+        std::condition_variable cv{};
+        std::vector<std::vector<Entry>> batches{};
+        std::string filter{}, chosen{};
+        SortBy sortBy = SortBy::NAME;
+        bool descending = false, scanning = false, reset = false, quit = false;
+        std::atomic<unsigned> request{ 0 }, scanGen{ 0 };
+        Window *win{};
+        FilePicker *owner;
+        Scan scanner{};
+        // superseded scans may be stuck in a slow directory and are only joined once finished
+        std::vector<Scan> retired{};
+        std::thread viewer{};
+        // owned by the viewer thread
+        std::vector<Entry> entries{};
+        std::vector<std::uint32_t> view{};
+
+        explicit Worker(FilePicker *owner) : owner(owner) {}
+
+        static std::string lowered(std::string_view text) {
+            std::string out(text);
+            for (char &c : out)
+                if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            return out;
+        }
+
+        // the parent entry first, then directories, then by key and name
+        static bool before(const Entry &a, const Entry &b, SortBy by, bool desc) {
+            if (a.parent != b.parent) return a.parent;
+            if (a.dir != b.dir) return a.dir;
+            int key = 0;
+            if (by == SortBy::SIZE)
+                key = (a.size > b.size) - (a.size < b.size);
+            else if (by == SortBy::MODIFIED)
+                key = (a.mtime > b.mtime) - (a.mtime < b.mtime);
+            if (key == 0)
+                key = a.lower.compare(b.lower);
+            return desc ? key > 0 : key < 0;
+        }
+
+        void open(std::string path, Window *window) {
+            stop();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                batches.clear();
+                chosen.clear();
+                scanning = reset = true;
+                win = window;
+                ++request;
+            }
+            cv.notify_one();
+            scanner.finished = std::make_shared<std::atomic<bool>>(false);
+            scanner.thread = std::thread([this, path = std::move(path), gen = scanGen.load(),
+                finished = scanner.finished] {
+                scan(path, gen);
+                *finished = true;
+            });
+        }
+
+        // never waits for the scanner, it notices the new generation on its next entry
+        void stop() {
+            ++scanGen;
+            if (scanner.thread.joinable())
+                retired.push_back(std::move(scanner));
+            scanner = {};
+            for (auto it = retired.begin(); it != retired.end();) {
+                if (!*it->finished) {
+                    ++it;
+                    continue;
+                }
+                it->thread.join();
+                it = retired.erase(it);
+            }
+        }
+
+        void configure(std::string_view filt, SortBy by, bool desc) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                filter = lowered(filt);
+                sortBy = by;
+                descending = desc;
+                ++request;
+            }
+            cv.notify_one();
+        }
+
+        void choose(const std::string &name) {
+            std::lock_guard<std::mutex> lock(mtx);
+            chosen = name;
+        }
+
+        bool deliver(std::vector<Entry> &&batch, unsigned gen, bool done) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (scanGen != gen) return false;
+                if (!batch.empty())
+                    batches.push_back(std::move(batch));
+                if (done)
+                    scanning = false;
+            }
+            cv.notify_one();
+            return true;
+        }
+
+        // scanner thread, hands over entries in batches of bounded size and age
+        void scan(std::string path, unsigned gen) {
+            namespace fs = std::filesystem;
+            const fs::path dirPath = fs::u8path(path);
+            std::vector<Entry> batch;
+            batch.reserve(batchSize);
+            if (dirPath.has_relative_path())
+                batch.push_back({ "..", "..", 0, 0, true, true });
+
+            std::error_code ec;
+            fs::directory_iterator it(dirPath, fs::directory_options::skip_permission_denied, ec);
+            Uint32 last = SDL_GetTicks();
+            for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+                if (scanGen != gen) return;
+                // on Windows these come with the directory listing, elsewhere they cost a stat
+                std::error_code attr;
+                Entry entry;
+                entry.name = it->path().filename().u8string();
+                entry.lower = lowered(entry.name);
+                entry.dir = it->is_directory(attr);
+                if (!entry.dir) {
+                    const auto size = it->file_size(attr);
+                    entry.size = attr ? 0 : size;
+                }
+                const auto time = it->last_write_time(attr);
+                if (!attr)
+                    entry.mtime = (long long)time.time_since_epoch().count();
+                batch.push_back(std::move(entry));
+
+                if (batch.size() >= batchSize || SDL_GetTicks() - last >= batchMs) {
+                    if (!deliver(std::move(batch), gen, false)) return;
+                    batch = {};
+                    batch.reserve(batchSize);
+                    last = SDL_GetTicks();
+                }
+            }
+            deliver(std::move(batch), gen, true);
+        }
+
+        // viewer thread, merges new batches into the sorted view, rebuilds it when
+        // the filter, sort or directory changes, and publishes at most every publishMs
+        void run(std::weak_ptr<Worker> self) {
+            unsigned served = 0;
+            bool unpublished = false, wasScanning = false;
+            Uint32 published = 0;
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true) {
+                const auto ready = [&] {
+                    return quit || served != request || !batches.empty() || wasScanning != scanning;
+                };
+                if (unpublished)
+                    cv.wait_for(lock, std::chrono::milliseconds(publishMs), ready);
+                else
+                    cv.wait(lock, ready);
+                if (quit) return;
+
+                const bool rebuild = served != request;
+                const unsigned gen = served = request;
+                const bool clear = reset;
+                reset = false;
+                auto fresh = std::move(batches);
+                batches.clear();
+                const std::string filt = filter, sel = chosen;
+                const SortBy by = sortBy;
+                const bool desc = descending, busy = wasScanning = scanning;
+                Window *window = win;
+                lock.unlock();
+
+                if (clear)
+                    entries.clear();
+                const std::size_t from = rebuild ? 0 : entries.size();
+                for (auto &batch : fresh)
+                    for (auto &entry : batch)
+                        entries.push_back(std::move(entry));
+
+                const auto less = [&](std::uint32_t a, std::uint32_t b) {
+                    return before(entries[a], entries[b], by, desc);
+                };
+                if (rebuild)
+                    view.clear();
+                const std::size_t mid = view.size();
+                for (std::size_t i = from; i < entries.size(); ++i)
+                    if (filt.empty() || entries[i].parent || entries[i].lower.find(filt) != std::string::npos)
+                        view.push_back((std::uint32_t)i);
+                std::sort(view.begin() + mid, view.end(), less);
+                std::inplace_merge(view.begin(), view.begin() + mid, view.end(), less);
+                unpublished |= rebuild || !fresh.empty() || !busy;
+
+                const Uint32 now = SDL_GetTicks();
+                if (unpublished && (rebuild || !busy || now - published >= publishMs)) {
+                    publish(self, window, gen, sel, busy);
+                    unpublished = false;
+                    published = now;
+                }
+                lock.lock();
+            }
+        }
+
+        void publish(const std::weak_ptr<Worker> &self, Window *window, unsigned gen,
+            const std::string &sel, bool busy) {
+            if (!window || request != gen) return;
+            std::vector<std::string> names;
+            names.reserve(view.size());
+            int selIndex = -1;
+            for (auto i : view) {
+                const Entry &entry = entries[i];
+                if (!sel.empty() && entry.name == sel)
+                    selIndex = (int)names.size();
+                names.push_back(entry.dir ? entry.name + '/' : entry.name);
+            }
+            window->post([self, gen, names = std::move(names), selIndex,
+                total = entries.size(), busy]() mutable {
+                if (auto lk = self.lock(); lk && lk->owner && lk->request == gen)
+                    lk->owner->showEntries(std::move(names), selIndex, total, busy);
+            });
+        }
+
+        ~Worker() {
+            ++scanGen;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                quit = true;
+            }
+            cv.notify_one();
+            if (scanner.thread.joinable())
+                scanner.thread.join();
+            for (auto &scan : retired)
+                scan.thread.join();
+            if (viewer.joinable())
+                viewer.join();
+        }
+    };
+
+    FilePicker::FilePicker(SDL_Rect rect, const CompColors &colors) :
+        Panel(rect, colors.bg, colors.line), worker(std::make_shared<Worker>(this)) {
+        rawColors = colors;
+        const int pad = 4, barW = 12, buttonW = 80;
+        const int x = rect.x + pad, w = rect.w - 2 * pad;
+        int y = rect.y + pad;
+
+        pathText = static_cast<Text *>(Panel::addComponent(
+            std::make_unique<Text>(SDL_Rect{ x, y, w, rowH }, "", colors.text)));
+        y += rowH + pad;
+
+        const int filterW = w - 3 * sortW;
+        filterInput = static_cast<TextInput *>(Panel::addComponent(
+            std::make_unique<TextInput>(SDL_Rect{ x, y, filterW, rowH }, colors)));
+        filterInput->setChangeCallback([this](const std::string &val) { setFilter(val); });
+        for (int i = 0; i < 3; ++i) {
+            const SDL_Rect r{ x + filterW + i * sortW, y, sortW, rowH };
+            auto button = std::make_unique<Button>(r, "", colors, [this, i](Button *) {
+                const auto by = (SortBy)i;
+                setSort(by, by == sortBy && !descending);
+            });
+            sortButtons.push_back(static_cast<Button *>(Panel::addComponent(std::move(button))));
+        }
+        y += rowH + pad;
+
+        const int numShown = std::max(1, (rect.y + rect.h - y - rowH - 2 * pad) / rowH);
+        const SDL_Rect listRect{ x, y, w - barW, numShown * rowH };
+        list = static_cast<ListView *>(Panel::addComponent(
+            std::make_unique<ListView>(listRect, colors, numShown)));
+        Panel::addComponent(std::make_unique<ScrollBar>(
+            SDL_Rect{ x + w - barW, y, barW, listRect.h }, colors, list));
+        list->setCallback([this](int, const std::string &name) { pick(name); });
+        y += listRect.h + pad;
+
+        statusText = static_cast<Text *>(Panel::addComponent(
+            std::make_unique<Text>(SDL_Rect{ x, y, w - 2 * buttonW - pad, rowH }, "", colors.text)));
+        Panel::addComponent(std::make_unique<Button>(SDL_Rect{ x + w - 2 * buttonW, y, buttonW, rowH },
+            "Open", colors, [this](Button *) { finish(true); }));
+        Panel::addComponent(std::make_unique<Button>(SDL_Rect{ x + w - buttonW, y, buttonW, rowH },
+            "Cancel", colors, [this](Button *) { finish(false); }));
+
+        setSort(SortBy::NAME);
+        hide();
+        worker->viewer = std::thread(&Worker::run, worker.get(), std::weak_ptr<Worker>(worker));
     }
 
-    void TextInput::deactivate() {
-        active = false;
-        SDL_StopTextInput();
-        if (autoHide)
-            hide();
-        if (onConfirm)
-            onConfirm(text);
+    FilePicker::~FilePicker() {
+        worker->owner = nullptr;
+    }
+
+    void FilePicker::open(const std::string &path) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        const fs::path requested = fs::u8path(path);
+        const fs::path absolute = fs::absolute(requested, ec);
+        dir = (ec ? requested : absolute).lexically_normal().u8string();
+        chosen.clear();
+        pathText->text = dir;
+        statusText->text = "Reading...";
+        list->updateItems({}, -1);
+        show();
+        if (win)
+            win->setModal(this);
+        worker->open(dir, win);
+    }
+
+    void FilePicker::setFilter(std::string_view text) {
+        worker->configure(text, sortBy, descending);
+    }
+
+    void FilePicker::setSort(SortBy by, bool desc) {
+        static constexpr const char *labels[] = { "Name", "Size", "Date" };
+        sortBy = by;
+        descending = desc;
+        for (int i = 0; i < (int)sortButtons.size(); ++i)
+            sortButtons[i]->text = std::string(labels[i]) + ((SortBy)i != by ? "" : desc ? " v" : " ^");
+        setFilter(filterInput->value());
+    }
+
+    void FilePicker::showEntries(std::vector<std::string> &&names, int sel, std::size_t total, bool scanning) {
+        list->updateItems(std::move(names), sel);
+        statusText->text = (scanning ? "Reading... " : "")
+            + std::to_string(list->itemCount()) + " / " + std::to_string(total);
+        if (win) win->invalidate();
+    }
+
+    void FilePicker::pick(const std::string &name) {
+        namespace fs = std::filesystem;
+        if (name.empty() || name.back() != '/') {
+            chosen = name;
+            worker->choose(name);
+            return;
+        }
+        const fs::path sub = fs::u8path(name.substr(0, name.size() - 1));
+        open((fs::u8path(dir) / sub).lexically_normal().u8string());
+    }
+
+    void FilePicker::finish(bool accepted) {
+        namespace fs = std::filesystem;
+        worker->stop();
+        hide();
+        if (win && win->getModal() == this)
+            win->setModal(nullptr);
+        const std::string result = accepted && !chosen.empty()
+            ? (fs::u8path(dir) / fs::u8path(chosen)).u8string() : std::string{};
+        if (onDone)
+            onDone(result);
+    }
+
+    Component::EventStatus FilePicker::handleEvent(const SDL_Event &event) {
+        if (!shown) return IGNORED;
+        if (Panel::handleEvent(event)) return HANDLED;
+        if (event.type != SDL_KEYDOWN || filterInput->isActive()) return IGNORED;
+
+        switch (event.key.keysym.sym) {
+        case SDLK_UP:
+            list->moveSelection(-1);
+            return HANDLED;
+        case SDLK_DOWN:
+            list->moveSelection(1);
+            return HANDLED;
+        case SDLK_RETURN:
+        case SDLK_KP_ENTER:
+            if (list->selection() < 0) return IGNORED;
+            if (chosen == list->item(list->selection()))
+                finish(true);
+            else
+                list->select(list->selection());
+            return HANDLED;
+        default:
+            return IGNORED;
+        }
+    }
+
+    // exact 1D squared distance transform of f (Felzenszwalb and Huttenlocher)
+    static void distanceTransform1D(const float *f, float *d, int n, int *v, float *z) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -std::numeric_limits<float>::infinity();
+        z[1] = std::numeric_limits<float>::infinity();
+        for (int q = 1; q < n; ++q) {
+            float s;
+            while (true) {
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.f * (q - v[k]));
+                if (s > z[k] || k == 0) break;
+                --k;
+            }
+            if (s <= z[k]) s = z[k];
+            v[++k] = q;
+            z[k] = s;
+            z[k + 1] = std::numeric_limits<float>::infinity();
+        }
+        k = 0;
+        for (int q = 0; q < n; ++q) {
+            while (z[k + 1] < q) ++k;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    // grid holds 0 at feature pixels and a large value elsewhere, squared distances on return
+    static void distanceTransform(std::vector<float> &grid, int w, int h) {
+        const int n = std::max(w, h);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int x = 0; x < w; ++x) {
+            for (int y = 0; y < h; ++y) f[y] = grid[y * w + x];
+            distanceTransform1D(f.data(), d.data(), h, v.data(), z.data());
+            for (int y = 0; y < h; ++y) grid[y * w + x] = d[y];
+        }
+        for (int y = 0; y < h; ++y) {
+            distanceTransform1D(&grid[y * w], d.data(), w, v.data(), z.data());
+            std::copy(d.begin(), d.begin() + w, grid.begin() + y * w);
+        }
+    }
+
+    // alpha = clamp((dist - 128) * k + 1/2), blended over dst in 7-bit fixed point
+    static void sdfBlendRow(Uint32 *dst, const float *dist, int n, float k, Uint32 color) {
+        int x = 0;
+#ifdef SDLW_SSE2
+        const __m128 vk = _mm_set1_ps(k * 128.f), vbias = _mm_set1_ps((0.5f - 128.f * k) * 128.f);
+        const __m128 vzero = _mm_setzero_ps(), vmax = _mm_set1_ps(128.f);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+        for (; x + 4 <= n; x += 4) {
+            __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dist + x), vk), vbias);
+            const __m128i ai = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, vzero), vmax));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(ai, zero)) == 0xFFFF) continue;
+            // one alpha per pixel, repeated over its four 16-bit channels
+            const __m128i a16 = _mm_packs_epi32(ai, ai);
+            const __m128i pairs = _mm_unpacklo_epi16(a16, a16);
+            const __m128i a01 = _mm_unpacklo_epi32(pairs, pairs), a23 = _mm_unpackhi_epi32(pairs, pairs);
+            const __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+            __m128i lo = _mm_unpacklo_epi8(d, zero), hi = _mm_unpackhi_epi8(d, zero);
+            lo = _mm_add_epi16(lo, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(src, lo), a01), 7));
+            hi = _mm_add_epi16(hi, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(src, hi), a23), 7));
+            _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x < n; ++x) {
+            const float a = (dist[x] - 128.f) * k + 0.5f;
+            if (!(a > 0.f)) continue;
+            const int t = a < 1.f ? (int)(a * 128.f) : 128;
+            Uint32 out = 0;
+            for (int sh = 0; sh < 32; sh += 8) {
+                const int c = (dst[x] >> sh) & 0xFF, sc = (color >> sh) & 0xFF;
+                out |= Uint32(c + (((sc - c) * t) >> 7)) << sh;
+            }
+            dst[x] = out;
+        }
+    }
+
+    SdfFont::SdfFont(Font fontName, int baseSize, int spread) :
+        font(spread > 0 ? Painter::openFont(fontName, baseSize) : nullptr), baseSize(baseSize), spread(spread) {
+        if (spread <= 0)
+            error("SdfFont", "spread must be positive");
+        else if (!font)
+            error("SdfFont", TTF_GetError());
+    }
+
+    SdfFont::~SdfFont() {
+        Painter::closeFont(font);
+    }
+
+    const SdfFont::Glyph *SdfFont::glyph(Uint32 cp) {
+        if (auto it = glyphs.find(cp); it != glyphs.end())
+            return &it->second;
+        if (!font || frozen) return nullptr;
+
+        // rendered like drawString does, so advance and baseline match TTF text
+        SDL_Surface *mask = TTF_RenderUTF8_Solid(font, encodeCodepoint(cp).c_str(), SDL_Color{ 255, 255, 255, 255 });
+        if (!mask) return nullptr;
+        const int w = mask->w + 2 * spread, h = mask->h + 2 * spread;
+        if (w > atlasW) {
+            // keeps its advance but is never drawn, the cell would not fit on a shelf
+            SDL_FreeSurface(mask);
+            error("SdfFont", "glyph wider than the atlas");
+            return &(glyphs[cp] = Glyph{ 0, 0, 0, 0, w - 2 * spread });
+        }
+        constexpr float far = 1e20f;
+        // squared distances to the nearest glyph pixel and to the nearest background pixel
+        std::vector<float> toGlyph(1ull * w * h, far), toBackground(1ull * w * h, 0.f);
+        for (int y = 0; y < mask->h; ++y) {
+            const Uint8 *src = (const Uint8 *)mask->pixels + 1LL * y * mask->pitch;
+            for (int x = 0; x < mask->w; ++x) {
+                if (!src[x]) continue;
+                const std::size_t i = 1ull * (y + spread) * w + x + spread;
+                toGlyph[i] = 0.f;
+                toBackground[i] = far;
+            }
+        }
+        SDL_FreeSurface(mask);
+        distanceTransform(toGlyph, w, h);
+        distanceTransform(toBackground, w, h);
+
+        if (penX + w > atlasW) {
+            penX = 0;
+            penY += shelfH;
+            shelfH = 0;
+        }
+        shelfH = std::max(shelfH, h);
+        if (penY + shelfH > atlasH) {
+            atlasH = penY + shelfH;
+            atlas.resize(1ull * atlasW * atlasH, 0);
+        }
+        // 128 on the outline, one base pixel is 127 / spread levels
+        const float levels = 127.f / spread;
+        for (int y = 0; y < h; ++y) {
+            Uint8 *dst = &atlas[1ull * (penY + y) * atlasW + penX];
+            for (int x = 0; x < w; ++x) {
+                const std::size_t i = 1ull * y * w + x;
+                const float dist = std::sqrt(toBackground[i]) - std::sqrt(toGlyph[i]);
+                dst[x] = (Uint8)std::clamp(128.f + dist * levels, 0.f, 255.f);
+            }
+        }
+        const Glyph g{ penX, penY, w, h, w - 2 * spread };
+        penX += w;
+        return &(glyphs[cp] = g);
+    }
+
+    void SdfFont::preload(std::string_view text) {
+        for (std::size_t i = 0; i < text.size();)
+            glyph(nextCodepoint(text, i));
+    }
+
+    float SdfFont::measure(std::string_view text, float px) {
+        int advance = 0;
+        for (std::size_t i = 0; i < text.size();)
+            if (const Glyph *g = glyph(nextCodepoint(text, i)))
+                advance += g->advance;
+        return advance * px / baseSize;
+    }
+
+    void SdfFont::draw(Painter &p, float x, float y, std::string_view text, float px, Color color) {
+        SDL_Surface *dst = p.surface();
+        if (!dst || dst->format->BytesPerPixel != 4 || px <= 0.f) return;
+        const float scale = px / baseSize;
+        // antialiased over one destination pixel at any scale
+        const float k = spread * scale / 127.f;
+        const SDL_Rect clip = dst->clip_rect;
+        // per thread, so a frozen font is only read
+        thread_local std::vector<float> row;
+
+        float pen = x;
+        for (std::size_t i = 0; i < text.size();) {
+            const Glyph *g = glyph(nextCodepoint(text, i));
+            if (!g) continue;
+            const float left = pen - spread * scale, top = y - spread * scale;
+            const int x0 = std::max(clip.x, (int)std::floor(left));
+            const int x1 = std::min(clip.x + clip.w, (int)std::ceil(left + g->w * scale));
+            const int y0 = std::max(clip.y, (int)std::floor(top));
+            const int y1 = std::min(clip.y + clip.h, (int)std::ceil(top + g->h * scale));
+            pen += g->advance * scale;
+            if (!g->w || x0 >= x1 || y0 >= y1) continue;
+
+            row.resize(x1 - x0);
+            for (int dy = y0; dy < y1; ++dy) {
+                const float sy = std::clamp((dy + 0.5f - top) / scale - 0.5f, 0.f, g->h - 1.f);
+                const int ry = (int)sy, ry1 = std::min(ry + 1, g->h - 1);
+                const float ty = sy - ry;
+                const Uint8 *r0 = &atlas[1ull * (g->y + ry) * atlasW + g->x];
+                const Uint8 *r1 = &atlas[1ull * (g->y + ry1) * atlasW + g->x];
+                for (int dx = x0; dx < x1; ++dx) {
+                    const float sx = std::clamp((dx + 0.5f - left) / scale - 0.5f, 0.f, g->w - 1.f);
+                    const int rx = (int)sx, rx1 = std::min(rx + 1, g->w - 1);
+                    const float tx = sx - rx;
+                    const float a = r0[rx] + (r0[rx1] - r0[rx]) * tx;
+                    const float b = r1[rx] + (r1[rx1] - r1[rx]) * tx;
+                    row[dx - x0] = a + (b - a) * ty;
+                }
+                Uint32 *out = (Uint32 *)((Uint8 *)dst->pixels + 1LL * dy * dst->pitch) + x0;
+                sdfBlendRow(out, row.data(), x1 - x0, k, color);
+            }
+        }
     }
 
-    Component::EventStatus TextInput::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        if (!active && thisWasClicked(event)) {
-            activate();
-            return HANDLED;
+#ifdef _WIN32
+    static constexpr std::intptr_t invalidSocket = (std::intptr_t)INVALID_SOCKET;
+#else
+    static constexpr std::intptr_t invalidSocket = -1;
+#endif
+
+    static void socketClose(std::intptr_t sock) {
+        if (sock == invalidSocket) return;
+#ifdef _WIN32
+        closesocket((SOCKET)sock);
+#else
+        ::close((int)sock);
+#endif
+    }
+
+    // "unix:/path" or "host:port", loopback only unless the host says otherwise
+    static std::intptr_t socketListen(const std::string &address) {
+#ifdef _WIN32
+        static const bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) {
+            error("socketListen", "WSAStartup failed");
+            return invalidSocket;
         }
-        if (active) {
-            if (clickOutside(event)) {
-                deactivate();
-                return IGNORED;
+#endif
+        if (address.rfind("unix:", 0) == 0) {
+#ifdef _WIN32
+            error("socketListen", "UNIX sockets are not supported here");
+            return invalidSocket;
+#else
+            const std::string path = address.substr(5);
+            sockaddr_un addr{};
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+                error("socketListen", ("bad socket path " + path).c_str());
+                return invalidSocket;
             }
-            if (event.type == SDL_TEXTINPUT) {
-                insertChar(event.text.text[0], caretPos++);
-                return HANDLED;
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            ::unlink(path.c_str());
+            const int sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (sock < 0 || ::bind(sock, (const sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(sock, 8) != 0) {
+                error("socketListen", address.c_str());
+                socketClose(sock);
+                return invalidSocket;
             }
-            if (event.type == SDL_KEYDOWN)
-                return handleKey(event.key.keysym.sym) ? HANDLED : IGNORED;
+            return sock;
+#endif
         }
-        return IGNORED;
+
+        const std::size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            error("socketListen", ("expected host:port, got " + address).c_str());
+            return invalidSocket;
+        }
+        const std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+        addrinfo hints{}, *found = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        if (getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &found) != 0) {
+            error("socketListen", address.c_str());
+            return invalidSocket;
+        }
+        std::intptr_t sock = invalidSocket;
+        for (addrinfo *ai = found; ai && sock == invalidSocket; ai = ai->ai_next) {
+            sock = (std::intptr_t)::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (sock == invalidSocket) continue;
+            const int on = 1;
+            setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+            if (::bind(sock, ai->ai_addr, (int)ai->ai_addrlen) != 0 || ::listen(sock, 8) != 0) {
+                socketClose(sock);
+                sock = invalidSocket;
+            }
+        }
+        freeaddrinfo(found);
+        if (sock == invalidSocket)
+            error("socketListen", address.c_str());
+        return sock;
     }
 
-    bool TextInput::handleKey(int kp) {
-        switch (kp) {
-        case SDLK_LEFT:
-            --caretPos;
-            break;
-        case SDLK_RIGHT:
-            ++caretPos;
-            break;
-        case SDLK_HOME:
-            caretPos = 0;
-            break;
-        case SDLK_END:
-            caretPos = (int)text.length();
-            break;
-        case SDLK_DELETE:
-            deleteChar(caretPos);
-            break;
-        case SDLK_BACKSPACE:
-            deleteChar(--caretPos);
-            break;
-        case SDLK_KP_ENTER:
-        case SDLK_RETURN:
-        case SDLK_RETURN2:
-            deactivate();
+    static std::intptr_t socketAccept(std::intptr_t listener) {
+        const auto sock = (std::intptr_t)::accept(listener, nullptr, nullptr);
+        return sock < 0 ? invalidSocket : sock;
+    }
+
+#ifdef MSG_NOSIGNAL
+    static constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+    static constexpr int sendFlags = 0;
+#endif
+
+    static bool socketSend(std::intptr_t sock, const void *data, std::size_t len) {
+        const char *p = (const char *)data;
+        while (len > 0) {
+            const int sent = (int)::send(sock, p, (int)std::min<std::size_t>(len, 1 << 20), sendFlags);
+            if (sent <= 0) return false;
+            p += sent;
+            len -= sent;
+        }
+        return true;
+    }
+
+    static bool socketNonBlocking(std::intptr_t sock) {
+#ifdef _WIN32
+        u_long on = 1;
+        return ioctlsocket((SOCKET)sock, FIONBIO, &on) == 0;
+#else
+        const int flags = fcntl((int)sock, F_GETFL, 0);
+        return flags >= 0 && fcntl((int)sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    }
+
+    // non-blocking sockets only, removes what was sent from out; false once the peer is gone
+    static bool socketFlush(std::intptr_t sock, std::vector<Uint8> &out) {
+        std::size_t done = 0;
+        while (done < out.size()) {
+            const int sent = (int)::send(sock, (const char *)out.data() + done,
+                (int)std::min<std::size_t>(out.size() - done, 1 << 20), sendFlags);
+            if (sent > 0) {
+                done += sent;
+                continue;
+            }
+#ifdef _WIN32
+            const bool full = sent < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+            const bool full = sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+            if (!full) return false;
             break;
-        default:
-            return false;
         }
-        if (caretPos < 0)
-            caretPos = 0;
-        if (caretPos > (int)text.length())
-            caretPos = (int)text.length();
+        out.erase(out.begin(), out.begin() + done);
         return true;
     }
 
-    void TextInput::draw(Graphics &g) {
-        if (!shown) return;
-        g.drawRect(rect, 1, active ? colors.hl : colors.bg, colors.line);
-        g.drawString({rect.x + 10,rect.y,rect.w,rect.h},
-            text, win->font(), colors.text, false);
+    // appends what is available, false once the peer is gone
+    static bool socketRecv(std::intptr_t sock, std::vector<Uint8> &buffer) {
+        char chunk[4096];
+        const int got = (int)::recv(sock, chunk, sizeof(chunk), 0);
+        if (got <= 0) return false;
+        buffer.insert(buffer.end(), chunk, chunk + got);
+        return true;
     }
 
-    void TextInput::deleteChar(std::size_t index) {
-        if (index < 0 || index >= text.length()) return;
-        text = text.substr(0, index) + text.substr(index + 1);
+    // sockets that became readable within timeoutMs
+    static std::vector<std::intptr_t> socketWait(const std::vector<std::intptr_t> &socks, int timeoutMs) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        std::intptr_t top = 0;
+        for (auto sock : socks) {
+            FD_SET(sock, &readable);
+            top = std::max(top, sock);
+        }
+        timeval timeout{ timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+        std::vector<std::intptr_t> ready;
+        if (::select((int)top + 1, &readable, nullptr, nullptr, &timeout) > 0)
+            for (auto sock : socks)
+                if (FD_ISSET(sock, &readable))
+                    ready.push_back(sock);
+        return ready;
     }
 
-    void TextInput::insertChar(char chr, std::size_t index) {
-        if (index < 0 || index > text.length()) return;
-        text = text.substr(0, index) + char(chr) + text.substr(index);
+    // little-endian, as on every platform sdlw runs on
+    template <typename T>
+    static void putLE(std::vector<Uint8> &out, T val) {
+        const auto at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &val, sizeof(T));
     }
 
-    Dropdown::MiniPanel::MiniPanel(std::unique_ptr<Component> &&comp,
-        Dropdown *parent, bool allowDel, bool allowSwap) :
-        Component(SDL_Rect{}, parent->rawColors),
-        mainPart(std::move(comp)), parent(parent) {
-        if (allowDel) {
-            const SDL_Rect r{
-                mainPart->x() + mainPart->w() + 2 * buttonSize + 3 * buttonSpace,
-                mainPart->y() + (mainPart->h() - buttonSize) / 2,
-                buttonSize,
-                buttonSize
-            };
-            del = std::make_unique<Button>(r, "X", rawColors,
-                [this](Button *) { this->parent->removeAt(index); });
+    template <typename T>
+    static T getLE(const Uint8 *p) {
+        T val;
+        std::memcpy(&val, p, sizeof(T));
+        return val;
+    }
+
+    // u16 header: high bit set is a run of (low + 1) copies of the next word,
+    // otherwise (low + 1) literal words follow
+    static void rleEncode(const Uint32 *px, std::size_t n, std::vector<Uint8> &out) {
+        constexpr std::size_t maxCount = 0x8000;
+        const auto runAt = [&](std::size_t i) {
+            return i + 2 < n && px[i] == px[i + 1] && px[i] == px[i + 2];
+        };
+        std::size_t i = 0;
+        while (i < n) {
+            if (runAt(i)) {
+                std::size_t run = 3;
+                while (i + run < n && run < maxCount && px[i + run] == px[i]) ++run;
+                putLE<Uint16>(out, Uint16(0x8000 | (run - 1)));
+                putLE<Uint32>(out, px[i]);
+                i += run;
+                continue;
+            }
+            std::size_t end = i + 1;
+            while (end < n && end - i < maxCount && !runAt(end)) ++end;
+            putLE<Uint16>(out, Uint16(end - i - 1));
+            for (; i < end; ++i)
+                putLE<Uint32>(out, px[i]);
         }
-        if (allowSwap) {
-            SDL_Rect r{
-                mainPart->x() + mainPart->w() + buttonSpace,
-                mainPart->y() + (mainPart->h() - buttonSize) / 2,
-                buttonSize,
-                buttonSize
-            };
-            up = std::make_unique<Button>(r, "U", rawColors,
-                [this](Button *) { this->parent->swapElems(index, index - 1); });
-            r.x += (buttonSize + buttonSpace);
-            down = std::make_unique<Button>(r, "D", rawColors,
-                [this](Button *) { this->parent->swapElems(index, index + 1); });
+    }
+
+    /* Protocol, all integers little-endian.
+       server: "SDLWFB1\0", u32 width, u32 height, then messages
+         1 delta tile | 2 key tile: u16 x, y, w, h, u32 size, RLE of w * h pixels
+           (delta tiles are XORed with the previous contents, key tiles replace them)
+         3 frame end: u32 frame number
+       client:
+         1 motion: i16 x, y           2 button: u8 button, u8 down, i16 x, y
+         3 key: u8 down, i32 keycode  4 text: u8 length, UTF-8 bytes
+         5 wheel: i16 dy */
+    FrameServer::FrameServer(Window &window, const std::string &address) :
+        win(window), w(window.graphics().screen->w), h(window.graphics().screen->h),
+        listener(socketListen(address)),
+        staged(1ull * w * h), current(1ull * w * h), sent(1ull * w * h) {
+        if (listener == invalidSocket) return;
+        if (address.rfind("unix:", 0) == 0)
+            unixPath = address.substr(5);
+        // what is on screen now, a static window may not present again for a long time
+        const SDL_Surface *screen = win.graphics().screen;
+        for (int y = 0; y < h; ++y)
+            std::memcpy(&staged[1ull * y * w], (const Uint8 *)screen->pixels + 1LL * y * screen->pitch, 4ull * w);
+        current = sent = staged;
+        hookId = win.addPresentHook([this](const SDL_Rect &region) { capture(region); });
+        network = std::thread(&FrameServer::serve, this);
+        encoder = std::thread(&FrameServer::encode, this);
+    }
+
+    FrameServer::~FrameServer() {
+        if (hookId >= 0)
+            win.removePresentHook(hookId);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            quit = true;
         }
+        cv.notify_one();
+        if (network.joinable())
+            network.join();
+        if (encoder.joinable())
+            encoder.join();
+        clients.clear();
+        socketClose(listener);
+#ifndef _WIN32
+        if (!unixPath.empty())
+            ::unlink(unixPath.c_str());
+#endif
     }
 
-    void Dropdown::MiniPanel::translate(int x, int y) {
-        Component::translate(x, y);
-        mainPart->translate(x, y);
-        if (up) up->translate(x, y);
-        if (down) down->translate(x, y);
-        if (del) del->translate(x, y);
+    FrameServer::Client::~Client() {
+        socketClose(sock);
     }
 
-    void Dropdown::MiniPanel::setWindow(Window *window) {
-        Component::setWindow(window);
-        mainPart->setWindow(window);
-        if (up) up->setWindow(window);
-        if (down) down->setWindow(window);
-        if (del) del->setWindow(window);
-        mainPart->mapColors(window->graphics());
-        if (up) up->mapColors(window->graphics());
-        if (down) down->mapColors(window->graphics());
-        if (del) del->mapColors(window->graphics());
+    std::size_t FrameServer::clientCount() {
+        std::lock_guard<std::mutex> lock(clientMtx);
+        return clients.size();
     }
 
-    Component::EventStatus Dropdown::MiniPanel::handleEvent(const SDL_Event &event) {
-        return shown && (mainPart->handleEvent(event)
-            || (up && up->handleEvent(event))
-            || (down && down->handleEvent(event))
-            || (del && del->handleEvent(event))) ? HANDLED : IGNORED;
+    void FrameServer::capture(const SDL_Rect &region) {
+        const SDL_Surface *screen = win.graphics().screen;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int y = region.y; y < region.y + region.h; ++y)
+                std::memcpy(&staged[1ull * y * w + region.x],
+                    (const Uint8 *)screen->pixels + 1LL * y * screen->pitch + 4LL * region.x, 4ull * region.w);
+            if (SDL_RectEmpty(&damage))
+                damage = region;
+            else
+                SDL_UnionRect(&damage, &region, &damage);
+        }
+        cv.notify_one();
     }
 
-    void Dropdown::MiniPanel::draw(Graphics &g) {
-        if (!shown) return;
-        mainPart->draw(g);
-        if (up) up->draw(g);
-        if (down) down->draw(g);
-        if (del) del->draw(g);
+    void FrameServer::appendTile(std::vector<Uint8> &out, Uint8 type, const SDL_Rect &tile, bool delta) const {
+        std::vector<Uint32> px(1ull * tile.w * tile.h);
+        for (int y = 0; y < tile.h; ++y) {
+            const std::size_t row = 1ull * (tile.y + y) * w + tile.x;
+            for (int x = 0; x < tile.w; ++x)
+                px[1ull * y * tile.w + x] = delta ? current[row + x] ^ sent[row + x] : sent[row + x];
+        }
+        out.push_back(type);
+        putLE<Uint16>(out, (Uint16)tile.x);
+        putLE<Uint16>(out, (Uint16)tile.y);
+        putLE<Uint16>(out, (Uint16)tile.w);
+        putLE<Uint16>(out, (Uint16)tile.h);
+        const std::size_t sizeAt = out.size();
+        putLE<Uint32>(out, 0);
+        rleEncode(px.data(), px.size(), out);
+        const Uint32 size = Uint32(out.size() - sizeAt - 4);
+        std::memcpy(out.data() + sizeAt, &size, 4);
     }
 
-    Dropdown::Dropdown(SDL_Rect rect, SDL_Rect elemRect, std::string_view text,
-        short flags, int numShown, const CompColors &colors, ExpandDir expDir) :
-        Expandable(rect, text, colors, makePanel(elemRect, numShown), expDir),
-        elemRect(elemRect), flags(flags), elems(panel->components()) {
+    void FrameServer::encode() {
+        std::unique_lock<std::mutex> lock(mtx);
+        bool backlog = false;
+        while (true) {
+            const auto ready = [this] { return quit || newClient || !SDL_RectEmpty(&damage); };
+            // clients whose socket was full are retried every few ms
+            if (backlog)
+                cv.wait_for(lock, std::chrono::milliseconds(10), ready);
+            else
+                cv.wait(lock, ready);
+            if (quit) return;
+            const SDL_Rect region = damage;
+            damage = {};
+            newClient = false;
+            for (int y = region.y; y < region.y + region.h; ++y)
+                std::memcpy(&current[1ull * y * w + region.x], &staged[1ull * y * w + region.x], 4ull * region.w);
+            lock.unlock();
 
-        panel->rawColors = rawColors;
-        if (flags & Flags::ADD) {
-            const SDL_Rect r{
-                panel->x() + buttonSpace,
-                panel->y() + panel->h() - (elemRect.h + buttonSize) / 2,
-                buttonSize, buttonSize
-            };
-            addButton = std::make_unique<Button>(r, "+", rawColors);
+            // tiles on a fixed grid, skipped if the pixels did not actually change
+            std::vector<Uint8> deltas;
+            if (!SDL_RectEmpty(&region)) {
+                for (int ty = region.y / tileSize * tileSize; ty < region.y + region.h; ty += tileSize) {
+                    for (int tx = region.x / tileSize * tileSize; tx < region.x + region.w; tx += tileSize) {
+                        const SDL_Rect tile{ tx, ty, std::min(tileSize, w - tx), std::min(tileSize, h - ty) };
+                        bool same = true;
+                        for (int y = tile.y; same && y < tile.y + tile.h; ++y)
+                            same = std::memcmp(&current[1ull * y * w + tile.x], &sent[1ull * y * w + tile.x], 4ull * tile.w) == 0;
+                        if (same) continue;
+                        appendTile(deltas, 1, tile, true);
+                        for (int y = tile.y; y < tile.y + tile.h; ++y)
+                            std::memcpy(&sent[1ull * y * w + tile.x], &current[1ull * y * w + tile.x], 4ull * tile.w);
+                    }
+                }
+                deltas.push_back(3);
+                putLE<Uint32>(deltas, frame++);
+            }
+
+            // sent without holding clientMtx, the network thread keeps accepting and reading
+            std::vector<std::shared_ptr<Client>> targets;
+            {
+                std::lock_guard<std::mutex> cl(clientMtx);
+                targets = clients;
+            }
+            // about two uncompressed frames, a client further behind is dropped
+            const std::size_t maxBacklog = 8ull * w * h + (1u << 20);
+            std::vector<Uint8> key;
+            backlog = false;
+            for (auto &client : targets) {
+                if (!client->alive) continue;
+                auto &out = client->outbox;
+                if (!client->synced) {
+                    // joins with everything sent so far, this frame included
+                    if (key.empty()) {
+                        for (int ty = 0; ty < h; ty += tileSize)
+                            for (int tx = 0; tx < w; tx += tileSize)
+                                appendTile(key, 2, { tx, ty, std::min(tileSize, w - tx), std::min(tileSize, h - ty) }, false);
+                        key.push_back(3);
+                        putLE<Uint32>(key, frame);
+                    }
+                    out.insert(out.end(), key.begin(), key.end());
+                    client->synced = true;
+                }
+                else
+                    out.insert(out.end(), deltas.begin(), deltas.end());
+                if (!socketFlush(client->sock, out) || out.size() > maxBacklog) {
+                    client->alive = false;
+                    out = {};
+                }
+                backlog |= !out.empty();
+            }
+            lock.lock();
         }
     }
 
-    Component *Dropdown::addComponent(std::unique_ptr<Component> &&comp) {
-        auto mp = std::make_unique<MiniPanel>(std::move(comp), this,
-            flags & Flags::DEL, flags & Flags::SWAP);
-        mp->rawColors = rawColors;
-        mp->index = (int)elems.size();
-        mp->setWindow(win);
-        mp->setDims(elemRect.w + 4 * buttonSpace + 3 * buttonSize, elemRect.h);
-        //mp->mapColors(win->graphics());
+    bool FrameServer::readInput(Client &client) {
+        auto &in = client.input;
+        std::size_t at = 0;
+        while (at < in.size()) {
+            const Uint8 *msg = in.data() + at;
+            const std::size_t avail = in.size() - at;
+            static constexpr std::size_t sizes[] = { 0, 5, 7, 6, 2, 3 };
+            const Uint8 type = msg[0];
+            if (type == 0 || type > 5) return false;
+            std::size_t need = sizes[type];
+            if (type == 4 && avail >= 2)
+                need += msg[1];
+            if (avail < need) break;
 
-        return panel->addComponent(std::move(mp))->as<MiniPanel>()->mainPart.get();
+            SDL_Event event{};
+            switch (type) {
+            case 1:
+                event.type = SDL_MOUSEMOTION;
+                event.motion.x = getLE<Sint16>(msg + 1);
+                event.motion.y = getLE<Sint16>(msg + 3);
+                break;
+            case 2:
+                event.type = msg[2] ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                event.button.button = msg[1];
+                event.button.clicks = 1;
+                event.button.x = getLE<Sint16>(msg + 3);
+                event.button.y = getLE<Sint16>(msg + 5);
+                break;
+            case 3:
+                event.type = msg[1] ? SDL_KEYDOWN : SDL_KEYUP;
+                event.key.keysym.sym = getLE<Sint32>(msg + 2);
+                break;
+            case 4: {
+                event.type = SDL_TEXTINPUT;
+                const std::size_t len = std::min<std::size_t>(msg[1], sizeof(event.text.text) - 1);
+                std::memcpy(event.text.text, msg + 2, len);
+                event.text.text[len] = '\0';
+                break;
+            }
+            case 5:
+                event.type = SDL_MOUSEWHEEL;
+                event.wheel.y = getLE<Sint16>(msg + 1);
+                break;
+            }
+            // thread-safe, picked up by Window::events
+            SDL_PushEvent(&event);
+            at += need;
+        }
+        in.erase(in.begin(), in.begin() + at);
+        return true;
     }
 
-    void Dropdown::removeAt(int index) {
-        if (index >= 0 && index < (int)elems.size()) {
-            elems.erase(elems.begin() + index);
-            reindex(index);
+    void FrameServer::serve() {
+        std::vector<Uint8> hello{ 'S', 'D', 'L', 'W', 'F', 'B', '1', 0 };
+        putLE<Uint32>(hello, (Uint32)w);
+        putLE<Uint32>(hello, (Uint32)h);
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (quit) return;
+            }
+            std::vector<std::intptr_t> socks{ listener };
+            {
+                std::lock_guard<std::mutex> cl(clientMtx);
+                // drop clients whose send or receive failed
+                for (auto it = clients.begin(); it != clients.end();) {
+                    if ((*it)->alive) {
+                        socks.push_back((*it)->sock);
+                        ++it;
+                        continue;
+                    }
+                    it = clients.erase(it);
+                }
+            }
+
+            for (auto sock : socketWait(socks, 100)) {
+                if (sock == listener) {
+                    const auto accepted = socketAccept(listener);
+                    if (accepted == invalidSocket) continue;
+                    // the hello fits any empty socket buffer, frames never block the encoder
+                    if (!socketSend(accepted, hello.data(), hello.size()) || !socketNonBlocking(accepted)) {
+                        socketClose(accepted);
+                        continue;
+                    }
+                    {
+                        std::lock_guard<std::mutex> cl(clientMtx);
+                        clients.push_back(std::make_shared<Client>(accepted));
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mtx);
+                        newClient = true;
+                    }
+                    cv.notify_one();
+                    continue;
+                }
+                std::shared_ptr<Client> client;
+                {
+                    std::lock_guard<std::mutex> cl(clientMtx);
+                    for (auto &c : clients)
+                        if (c->sock == sock) client = c;
+                }
+                if (!client) continue;
+                if (!socketRecv(sock, client->input) || !readInput(*client))
+                    client->alive = false;
+            }
         }
     }
 
-    void Dropdown::swapElems(int ind1, int ind2) {
-        if (ind1 < 0
-            || ind2 < 0
-            || ind1 >= (int)elems.size()
-            || ind2 >= (int)elems.size())
-            return;
+    static void collectNodes(Component &comp, const std::string &id, std::vector<AutomationServer::Node> &out) {
+        out.push_back({ id, comp.valueText(), comp.getRect(), comp.isVisible() });
+        const auto children = [&](Panel *panel) {
+            if (!panel) return;
+            for (std::size_t i = 0; i < panel->count(); ++i)
+                collectNodes(*panel->components()[i], id + '/' + std::to_string(i), out);
+        };
+        if (auto panel = comp.as<Panel>())
+            children(panel);
+        else if (auto exp = comp.as<Expandable>())
+            children(exp->getPanel());
+        else if (auto tabs = comp.as<Tabs>())
+            children(tabs->activeIndex() < 0 ? nullptr : tabs->page(tabs->activeIndex()));
+        else if (auto split = comp.as<Splitter>())
+            for (int i = 0; i < 2; ++i)
+                if (split->pane(i))
+                    collectNodes(*split->pane(i), id + '/' + std::to_string(i), out);
+    }
 
-        std::swap(elems[ind1], elems[ind2]);
-        std::swap(
-            elems[ind1]->as<MiniPanel>()->index,
-            elems[ind2]->as<MiniPanel>()->index
-        );
+    // one value per line, so newlines and backslashes are escaped
+    static std::string escapeLine(std::string_view text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '\n') out += "\\n";
+            else if (c == '\\') out += "\\\\";
+            else out += c;
+        }
+        return out;
     }
 
-    void Dropdown::setWindow(Window *window) {
-        Expandable::setWindow(window);
-        addButton->setWindow(window);
-        addButton->mapColors(window->graphics());
+    /* Line protocol, one command per line, every reply ends with "ok" or "error <reason>".
+         tree                     frame <n> <inputs>, then node <id> <x> <y> <w> <h> <visible> <value>
+         get <id>                 the node line of one component
+         click <id> [button]      motion, press and release at the component's center
+         move <x> <y>
+         press|release <x> <y> [button]
+         key <name|keycode> [down|up]   both by default, names as SDL_GetKeyFromName takes them
+         text <utf-8 text>        the rest of the line
+         wheel <dy>
+         wait frame [timeoutMs]   until the input sent so far is handled and a frame is presented
+         wait idle [quietMs] [timeoutMs]   until the input sent so far is handled and nothing
+                                  was presented for quietMs
+       Snapshots are taken on present, and only while a client is connected; the first client
+       triggers a redraw, so "wait frame" before "tree" guarantees a current tree. Waits time
+       out while presentation is suspended. */
+    AutomationServer::AutomationServer(Window &window, const std::string &address) :
+        win(window), listener(socketListen(address)),
+        applied(std::make_shared<std::atomic<Uint32>>(0)),
+        current(std::make_shared<const Snapshot>()) {
+        if (listener == invalidSocket) return;
+        if (address.rfind("unix:", 0) == 0)
+            unixPath = address.substr(5);
+        hookId = win.addPresentHook([this](const SDL_Rect &) {
+            if (connected.load(std::memory_order_acquire))
+                publish();
+        });
+        publish();
+        network = std::thread(&AutomationServer::serve, this);
     }
 
-    void Dropdown::setFactory(FactoryCallback &&fcb) {
-        addButton->setCallback([this, fact = std::move(fcb)](Button *) {
-            addComponent(fact((int)elems.size()));
+    AutomationServer::~AutomationServer() {
+        if (hookId >= 0)
+            win.removePresentHook(hookId);
+        quit = true;
+        if (network.joinable())
+            network.join();
+        for (auto &client : clients)
+            socketClose(client.sock);
+        socketClose(listener);
+#ifndef _WIN32
+        if (!unixPath.empty())
+            ::unlink(unixPath.c_str());
+#endif
+    }
+
+    void AutomationServer::publish() {
+        auto snap = std::make_shared<Snapshot>();
+        snap->frame = ++frame;
+        snap->presentedAt = SDL_GetTicks();
+        snap->inputs = applied->load(std::memory_order_acquire);
+        win.forEachComponent([&](std::string_view id, Component &comp) {
+            collectNodes(comp, std::string(id), snap->nodes);
         });
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(snap)));
     }
 
-    void Dropdown::draw(Graphics &g) {
-        Expandable::draw(g);
-        if (shown && expanded)
-            addButton->draw(g);
+    void AutomationServer::inject(Client &client, std::initializer_list<SDL_Event> events) {
+        for (auto event : events)
+            SDL_PushEvent(&event);
+        // the task runs in the same pass over the queue as the events, or a later one,
+        // and deferring it puts it after the whole pass
+        const Uint32 seq = client.lastInput = ++injected;
+        Window *window = &win;
+        win.post([window, counter = applied, seq] {
+            window->defer([counter, seq] { counter->store(seq, std::memory_order_release); });
+        });
     }
 
-    Component::EventStatus Dropdown::handleEvent(const SDL_Event &event) {
-        if (!shown) return IGNORED;
-        if (auto stat = addButton->handleEvent(event))
-            return stat;
-        if (auto stat = Expandable::handleEvent(event)) {
-            panel->as<ScrollPanel>()->scrollContent();
-            return stat;
+    static void nodeLine(std::string &out, const AutomationServer::Node &node) {
+        out += "node " + node.id + ' ' + std::to_string(node.rect.x) + ' ' + std::to_string(node.rect.y) + ' '
+            + std::to_string(node.rect.w) + ' ' + std::to_string(node.rect.h) + ' '
+            + (node.visible ? '1' : '0') + ' ' + escapeLine(node.value) + '\n';
+    }
+
+    bool AutomationServer::command(Client &client, const std::string &line) {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+        const auto snap = snapshot();
+        const auto find = [&](const std::string &id) -> const Node * {
+            for (auto &node : snap->nodes)
+                if (node.id == id) return &node;
+            return nullptr;
+        };
+        const auto mouse = [](Uint32 type, int x, int y, int button) {
+            SDL_Event event{};
+            event.type = type;
+            if (type == SDL_MOUSEMOTION) {
+                event.motion.x = x;
+                event.motion.y = y;
+            }
+            else {
+                event.button.button = (Uint8)button;
+                event.button.clicks = 1;
+                event.button.x = x;
+                event.button.y = y;
+            }
+            return event;
+        };
+
+        std::string reply;
+        const char *err = nullptr;
+        if (cmd == "tree") {
+            reply = "frame " + std::to_string(snap->frame) + ' ' + std::to_string(snap->inputs) + '\n';
+            for (auto &node : snap->nodes)
+                nodeLine(reply, node);
         }
-        return IGNORED;
+        else if (cmd == "get" || cmd == "click") {
+            std::string id;
+            int button = SDL_BUTTON_LEFT;
+            in >> id >> button;
+            const Node *node = find(id);
+            if (!node)
+                err = "no such component";
+            else if (cmd == "get")
+                nodeLine(reply, *node);
+            else {
+                const int x = node->rect.x + node->rect.w / 2, y = node->rect.y + node->rect.h / 2;
+                inject(client, { mouse(SDL_MOUSEMOTION, x, y, 0),
+                    mouse(SDL_MOUSEBUTTONDOWN, x, y, button), mouse(SDL_MOUSEBUTTONUP, x, y, button) });
+            }
+        }
+        else if (cmd == "move" || cmd == "press" || cmd == "release") {
+            int x, y, button = SDL_BUTTON_LEFT;
+            if (!(in >> x >> y))
+                err = "expected x y";
+            else {
+                in >> button;
+                inject(client, { mouse(cmd == "move" ? SDL_MOUSEMOTION
+                    : cmd == "press" ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP, x, y, button) });
+            }
+        }
+        else if (cmd == "key") {
+            std::string name, dir;
+            in >> name >> dir;
+            SDL_Keycode sym = SDL_GetKeyFromName(name.c_str());
+            if (sym == SDLK_UNKNOWN && !name.empty())
+                std::from_chars(name.data(), name.data() + name.size(), sym);
+            if (sym == SDLK_UNKNOWN)
+                err = "unknown key";
+            else {
+                SDL_Event down{}, up{};
+                down.type = SDL_KEYDOWN;
+                up.type = SDL_KEYUP;
+                down.key.keysym.sym = up.key.keysym.sym = sym;
+                if (dir == "down") inject(client, { down });
+                else if (dir == "up") inject(client, { up });
+                else inject(client, { down, up });
+            }
+        }
+        else if (cmd == "text") {
+            std::string_view text(line);
+            text.remove_prefix(std::min(text.size(), cmd.size() + 1));
+            // SDL_TEXTINPUT holds 31 bytes, split between code points
+            while (!text.empty()) {
+                SDL_Event event{};
+                event.type = SDL_TEXTINPUT;
+                std::size_t len = std::min(text.size(), sizeof(event.text.text) - 1);
+                while (len < text.size() && len > 0 && ((Uint8)text[len] & 0xC0) == 0x80)
+                    --len;
+                std::memcpy(event.text.text, text.data(), len);
+                event.text.text[len] = '\0';
+                inject(client, { event });
+                text.remove_prefix(len);
+            }
+        }
+        else if (cmd == "wheel") {
+            int dy;
+            if (!(in >> dy))
+                err = "expected dy";
+            else {
+                SDL_Event event{};
+                event.type = SDL_MOUSEWHEEL;
+                event.wheel.y = dy;
+                inject(client, { event });
+            }
+        }
+        else if (cmd == "wait") {
+            std::string kind;
+            Uint32 quietMs = 100, timeoutMs = 5000;
+            in >> kind;
+            if (kind == "idle")
+                in >> quietMs;
+            in >> timeoutMs;
+            if (kind != "frame" && kind != "idle")
+                err = "expected frame or idle";
+            else {
+                client.wait = { kind == "frame" ? Wait::FRAME : Wait::IDLE,
+                    snap->frame, quietMs, SDL_GetTicks() + timeoutMs };
+                return waitDone(client);
+            }
+        }
+        else
+            err = "unknown command";
+
+        reply += err ? std::string("error ") + err + '\n' : std::string("ok\n");
+        socketSend(client.sock, reply.data(), reply.size());
+        return true;
     }
 
-    std::unique_ptr<ScrollPanel> Dropdown::makePanel(const SDL_Rect &rect, int numShown) {
-        const SDL_Rect panelRect{ 0, 0,
-            rect.w + 4 * buttonSpace + 3 * buttonSize, rect.h * (numShown + 1) };
-        return std::make_unique<ScrollPanel>(panelRect, 0, 0, numShown);
+    bool AutomationServer::waitDone(Client &client) {
+        const auto snap = snapshot();
+        const Wait &wait = client.wait;
+        const Uint32 now = SDL_GetTicks();
+        const bool handled = (Sint32)(snap->inputs - client.lastInput) >= 0;
+        const bool done = handled && (wait.kind == Wait::FRAME
+            ? snap->frame != wait.frame : now - snap->presentedAt >= wait.quietMs);
+        const bool expired = (Sint32)(now - wait.deadline) >= 0;
+        if (!done && !expired)
+            return false;
+        const std::string reply = done ? "ok\n" : "error timeout\n";
+        socketSend(client.sock, reply.data(), reply.size());
+        client.wait = {};
+        return true;
     }
 
-    void Dropdown::reindex(int from) {
-        for (std::size_t i = from; i < elems.size(); ++i) {
-            elems[i]->as<MiniPanel>()->index = (int)i;
+    void AutomationServer::serve() {
+        while (!quit) {
+            std::vector<std::intptr_t> socks{ listener };
+            bool waiting = false;
+            for (auto &client : clients) {
+                socks.push_back(client.sock);
+                waiting |= client.wait.kind != Wait::NONE;
+            }
+            // waits are polled against the snapshot, a few times per frame
+            const auto ready = socketWait(socks, waiting ? 5 : 100);
+            if (std::find(ready.begin(), ready.end(), listener) != ready.end()) {
+                const auto accepted = socketAccept(listener);
+                if (accepted != invalidSocket) {
+                    clients.push_back({ accepted });
+                    // the snapshot went stale while nobody was connected, a small
+                    // redraw makes the next present publish a fresh one
+                    if (connected.fetch_add(1, std::memory_order_release) == 0) {
+                        Window *window = &win;
+                        win.post([window] { window->invalidate({ 0, 0, 1, 1 }); });
+                    }
+                }
+            }
+
+            for (auto it = clients.begin(); it != clients.end();) {
+                Client &client = *it;
+                bool alive = true;
+                if (std::find(ready.begin(), ready.end(), client.sock) != ready.end())
+                    alive = socketRecv(client.sock, client.input);
+                // commands run in order, a pending wait holds back the ones after it
+                bool idle = client.wait.kind == Wait::NONE || waitDone(client);
+                while (alive && idle) {
+                    const auto eol = std::find(client.input.begin(), client.input.end(), '\n');
+                    if (eol == client.input.end()) break;
+                    std::string line(client.input.begin(), eol);
+                    client.input.erase(client.input.begin(), eol + 1);
+                    if (!line.empty() && line.back() == '\r')
+                        line.pop_back();
+                    if (!line.empty())
+                        idle = command(client, line);
+                }
+                if (alive) {
+                    ++it;
+                    continue;
+                }
+                socketClose(client.sock);
+                it = clients.erase(it);
+                connected.fetch_sub(1, std::memory_order_relaxed);
+            }
         }
     }
+
+    BatchRenderer::BatchRenderer(int width, int height, unsigned threads, Font fontName, int fontSize) :
+        w(width), h(height), threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+        fontName(fontName), fontSize(fontSize) {}
+
+    bool BatchRenderer::render(std::size_t count, const Build &build, const Sink &sink) {
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> ok{ true };
+        const auto work = [&] {
+            // reused for every image this thread renders, so fonts are opened
+            // once per thread and the glyph and text caches stay warm
+            Window win(w, h, "", fontName, fontSize, true);
+            if (!win.graphics().isValid() || !win.font()) {
+                ok = false;
+                return;
+            }
+            for (std::size_t i; (i = next++) < count;) {
+                win.clearComponents();
+                build(win, i);
+                sink(i, win.renderFrame());
+            }
+            win.clearComponents();
+        };
+
+        std::vector<std::thread> pool;
+        const std::size_t spawn = std::min<std::size_t>(threads, count);
+        for (std::size_t t = 1; t < spawn; ++t)
+            pool.emplace_back(work);
+        if (spawn)
+            work();
+        for (auto &thread : pool)
+            thread.join();
+        return ok;
+    }
 }
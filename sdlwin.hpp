@@ -9,6 +9,17 @@
 #include <functional>
 #include <sstream>
 #include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <tuple>
+#include <list>
+#include <utility>
+#include <type_traits>
 
 namespace sdlw {
     using Color = Uint32;
@@ -31,73 +42,470 @@ namespace sdlw {
         return { p1.x - p2.x, p1.y - p2.y };
     }
 
-    class Graphics {
-    private:
-        bool valid;
-        int w, h;
-    public:
-        SDL_Renderer *renderer;
-        SDL_Surface *screen;
-        SDL_Texture *scrtex;
-        SDL_Window *window;
+    class SdfFont;
 
-        Graphics(int w, int h);
-
-        inline bool isValid() const { return valid; }
+    // Drawing primitives on any surface in the screen's pixel format.
+    class Painter {
+    protected:
+        SDL_Surface *target{};
+    public:
+        Painter() = default;
+        explicit Painter(SDL_Surface *target) : target(target) {}
 
+        inline SDL_Surface *surface() const { return target; }
         inline Color color(int rgb) const {
-            return SDL_MapRGB(screen->format,
+            return SDL_MapRGB(target->format,
                 (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
         }
+        static const char *fontPath(Font fontName);
+        // handed over by the active Preloader if it loaded this font, otherwise opened now
         static TTF_Font *getFont(Font fontName, int fontSize);
+        // from the mounted AssetPack if it has the font, otherwise from ./fonts/;
+        // thread-safe, but each font may only be used by one thread at a time
+        static TTF_Font *openFont(Font fontName, int fontSize);
+        // serialized with openFont, all fonts share SDL_ttf's FreeType library
+        static void closeFont(TTF_Font *font);
 
-        inline void clear() { SDL_FillRect(screen, NULL, 0x000000); }
+        inline void fill(Color color) { SDL_FillRect(target, NULL, color); }
         void drawPixel(int x, int y, Color color);
+        void drawLine(int x1, int y1, int x2, int y2, Color color);
         void drawRect(SDL_Rect rect, Color color);
         void drawRect(SDL_Rect rect, int borderW, Color color, Color borderColor);
+        // Graphics keeps the font open; a plain Painter opens and closes it per call,
+        // serialized with every other font open
         void drawString(int x, int y, std::string_view text, int fontSize, Font fontName, Color color);
         void drawString(int x, int y, std::string_view text, TTF_Font *font, Color color);
         void drawString(SDL_Rect rect, std::string_view text, TTF_Font *font, Color color,
             bool hCenter = true, bool vCenter = true);
+        // any pixel size from one distance field atlas, (x, y) is the top left of the line
+        void drawString(float x, float y, std::string_view text, SdfFont &font, float px, Color color);
+
+        virtual ~Painter() = default;
+    protected:
+        static SDL_Color sdlc(Color color);
+        // shaped run by run for each script and direction when SDL_ttf supports it,
+        // runs ordered by the first one's direction (no full bidi reordering);
+        // taken from the GlyphCache when rendered by an earlier process;
+        // the caller frees the surface if owned is set
+        virtual SDL_Surface *renderText(TTF_Font *font, std::string_view text, Color color, bool &owned);
+        // for drawString by font name and size; the caller closes the font if owned is set
+        virtual TTF_Font *sizedFont(Font fontName, int fontSize, bool &owned);
+    };
+
+    class Graphics : public Painter {
+    private:
+        struct GlyphKey {
+            TTF_Font *font;
+            Uint32 ch;
+            Color color;
+
+            inline bool operator==(const GlyphKey &o) const {
+                return font == o.font && ch == o.ch && color == o.color;
+            }
+        };
+        struct GlyphHash {
+            inline std::size_t operator()(const GlyphKey &k) const {
+                return std::hash<const void *>()(k.font) ^ (std::size_t(k.ch) << 1) ^ (std::size_t(k.color) << 17);
+            }
+        };
+
+        // a rendered, shaped string
+        struct TextRun {
+            TTF_Font *font;
+            Color color;
+            std::string text;
+            Uint64 hash;
+            SDL_Surface *surface;
+        };
+
+        bool valid;
+        int w, h;
+        std::unordered_map<GlyphKey, SDL_Surface *, GlyphHash> glyphs{};
+        // most recently used first
+        std::list<TextRun> texts{};
+        std::unordered_map<Uint64, std::list<TextRun>::iterator> textIndex{};
+        // opened by drawString by font name and size, kept open until destruction
+        std::map<std::pair<Font, int>, TTF_Font *> sizedFonts{};
+        // fonts closed since the caches were last used, a new font may reuse the address
+        std::vector<TTF_Font *> closedFonts{};
+        std::atomic<bool> fontsClosed{ false };
+        // every live Graphics, guarded like closedFonts by the font mutex
+        static std::vector<Graphics *> instances;
+    public:
+        SDL_Renderer *renderer{};
+        SDL_Surface *screen{};
+        SDL_Texture *scrtex{};
+        SDL_Window *window{};
+
+        // headless creates only the screen surface, and can be used on any thread
+        Graphics(int w, int h, bool headless = false);
+
+        inline bool isValid() const { return valid; }
+
+        inline void clear() { SDL_FillRect(screen, NULL, 0x000000); }
+        // rendered once per font, character and color, owned by the Graphics object
+        SDL_Surface *glyph(TTF_Font *font, Uint16 ch, Color color);
+        // distinct strings kept shaped and rendered, least recently used dropped first
+        std::size_t textCacheSize = 512;
+        // drops cached glyphs and strings of the font
+        void forgetFont(TTF_Font *font);
+        // called by Painter::closeFont, every Graphics forgets the font before its next draw
+        static void fontClosed(TTF_Font *font);
 
         ~Graphics();
+    protected:
+        SDL_Surface *renderText(TTF_Font *font, std::string_view text, Color color, bool &owned) override;
+        TTF_Font *sizedFont(Font fontName, int fontSize, bool &owned) override;
     private:
-        bool initItems(int w, int h);
-        static SDL_Color sdlc(Color color);
+        bool initItems(int w, int h, bool headless);
+        void forgetClosedFonts();
+    };
+
+    // Read-only memory mapping of a whole file, empty if it could not be mapped.
+    class MappedFile {
+    private:
+        const Uint8 *ptr{};
+        std::size_t len = 0;
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string &path);
+        MappedFile(MappedFile &&other) noexcept :
+            ptr(std::exchange(other.ptr, nullptr)), len(std::exchange(other.len, 0)) {}
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        ~MappedFile();
+
+        inline const Uint8 *data() const { return ptr; }
+        inline std::size_t size() const { return len; }
+        inline bool isOpen() const { return ptr != nullptr; }
+    };
+
+    // Glyph and text run bitmaps kept across runs in one memory-mapped file per
+    // font file hash, size and style. Disabled until setDirectory is called; new glyphs are
+    // written back by flush, which Graphics calls on destruction.
+    class GlyphCache {
+    private:
+        // a glyph's key is its character, a text run's is the hash of its text with
+        // the top bit set; runs keep their text after the bitmap to rule out collisions
+        struct Entry {
+            Uint64 key;
+            Uint32 offset;
+            Uint16 w, h, pitch, textLen;
+            Uint32 reserved;
+        };
+        struct Pending {
+            Uint16 w, h;
+            std::vector<Uint8> pixels;
+            std::string text{};
+        };
+        struct Archive {
+            std::string file;
+            MappedFile map{};
+            std::unordered_map<Uint64, Entry> index{};
+            std::map<Uint64, Pending> pending{};
+            std::size_t runs = 0;
+        };
+        static constexpr char magic[8] = { 'S', 'D', 'L', 'W', 'G', 'L', 'Y', '2' };
+        // runs past this are rendered every start, so changing text cannot grow the archive forever
+        static constexpr std::size_t maxRuns = 4096;
+
+        static std::mutex mtx;
+        static std::string dir;
+        static std::unordered_map<std::string, std::unique_ptr<Archive>> archives;
+        static std::unordered_map<TTF_Font *, Archive *> fonts;
+        static std::unordered_map<std::string, Uint64> fileHashes;
+    public:
+        static void setDirectory(std::string path);
+        // called by Painter::getFont and the Preloader for every font opened from a file
+        static void attach(TTF_Font *font, const char *fontFile, int size);
+        static void attach(TTF_Font *font, Uint64 fileHash, int size);
+        // called by Painter::closeFont, the pointer may be reused by the next font
+        static void detach(TTF_Font *font);
+        // an 8-bit surface equal to TTF_RenderGlyph_Solid, nullptr if not cached
+        static SDL_Surface *load(TTF_Font *font, Uint16 ch, int rgb);
+        static void store(TTF_Font *font, Uint16 ch, const SDL_Surface *glyph);
+        // the same for a whole run as rendered by Painter::renderText
+        static SDL_Surface *loadText(TTF_Font *font, std::string_view text, int rgb);
+        static void storeText(TTF_Font *font, std::string_view text, const SDL_Surface *run);
+        static void flush();
+    private:
+        static void mapArchive(Archive &archive);
+        static Uint64 hashFile(const std::string &path);
+        static Uint64 textKey(std::string_view text);
+        static SDL_Surface *load(TTF_Font *font, Uint64 key, std::string_view text, int rgb);
+        static void store(TTF_Font *font, Uint64 key, std::string_view text, const SDL_Surface *bitmap);
+    };
+
+    // Read-only archive of fonts, images and UI descriptions, memory-mapped as a
+    // whole. Entries are sorted by name and located by binary search in place;
+    // their bytes are never copied. Built by AssetPack::build or tools/mkpack.
+    class AssetPack {
+    public:
+        struct Asset {
+            const Uint8 *data{};
+            std::size_t size = 0;
+            // FNV-1a of the contents, computed when the pack is built
+            Uint64 hash = 0;
+
+            inline explicit operator bool() const { return data != nullptr; }
+            inline std::string_view text() const { return { (const char *)data, size }; }
+        };
+    private:
+        struct Entry {
+            Uint64 offset, size, hash;
+            Uint32 nameOffset, nameLen;
+        };
+        static constexpr char magic[8] = { 'S', 'D', 'L', 'W', 'P', 'A', 'K', '1' };
+        static constexpr std::size_t headerSize = sizeof(magic) + 8, dataAlign = 16;
+
+        static const AssetPack *mountedPack;
+
+        MappedFile map;
+        Uint32 count = 0;
+    public:
+        explicit AssetPack(const std::string &path);
+
+        inline bool isOpen() const { return map.isOpen(); }
+        inline std::size_t size() const { return count; }
+        std::string_view name(std::size_t index) const;
+        Asset find(std::string_view name) const;
+        // zero-copy stream over the asset, nullptr if missing; freed by the consumer
+        SDL_RWops *open(std::string_view name) const;
+        TTF_Font *openFont(std::string_view name, int size) const;
+        // BMP, converted to ARGB8888
+        SDL_Surface *loadImage(std::string_view name) const;
+
+        // Painter::openFont and the Preloader look here first, the pack must outlive its use
+        static inline void mount(const AssetPack *pack) { mountedPack = pack; }
+        static inline const AssetPack *mounted() { return mountedPack; }
+
+        // files are (name in the pack, source path)
+        static bool build(const std::string &packPath,
+            const std::vector<std::pair<std::string, std::string>> &files);
+    private:
+        Entry entry(std::size_t index) const;
+    };
+
+    // Opens fonts, prerenders their glyphs and decodes BMP images on a background
+    // thread while SDL and the window start up. Create it before the Window and
+    // keep it alive until the Window is gone; anything not taken is freed with it.
+    class Preloader {
+    public:
+        struct FontSpec {
+            Font font;
+            int size;
+            // prerendered for each color, 0xRRGGBB
+            std::u16string glyphs{};
+            std::vector<int> colors{};
+        };
+    private:
+        struct LoadedFont {
+            FontSpec spec;
+            TTF_Font *ttf{};
+            bool ready = false, taken = false;
+        };
+        struct LoadedImage {
+            std::string path;
+            SDL_Surface *surface{};
+            bool ready = false, taken = false;
+        };
+        using GlyphKey = std::tuple<TTF_Font *, Uint16, int>;
+
+        static Preloader *active;
+
+        std::mutex mtx{};
+        std::condition_variable cv{};
+        std::vector<LoadedFont> fonts;
+        std::vector<LoadedImage> images;
+        std::map<GlyphKey, SDL_Surface *> glyphs{};
+        Uint64 started;
+        std::atomic<bool> cancel{ false };
+        bool done = false;
+        std::thread worker{};
+    public:
+        Preloader(std::vector<FontSpec> fontSpecs, std::vector<std::string> imagePaths = {});
+        Preloader(const Preloader &) = delete;
+        Preloader &operator=(const Preloader &) = delete;
+        ~Preloader();
+
+        // performance counter at construction, or 0 without an active preloader
+        static Uint64 startTicks();
+        // wait for the item if it is still loading, nullptr if it was not requested;
+        // ownership passes to the caller
+        static TTF_Font *takeFont(Font font, int size);
+        static SDL_Surface *takeImage(std::string_view path);
+        // never waits, fonts are only handed over once their glyphs are rendered
+        static SDL_Surface *takeGlyph(TTF_Font *font, Uint16 ch, int rgb);
+    private:
+        void run();
+    };
+
+    // Shared by all components of a window, filled lazily on right-click.
+    class ContextMenu {
+    public:
+        using Action = std::function<void()>;
+    private:
+        struct Item {
+            std::string label;
+            Action action;
+        };
+        static constexpr int itemH = 22, minW = 120, padX = 8;
+
+        std::vector<Item> items{};
+        SDL_Rect rect{};
+        int hovered = -1;
+        bool open = false;
+    public:
+        inline bool isOpen() const { return open; }
+        inline int hoveredItem() const { return hovered; }
+        inline SDL_Rect getRect() const { return rect; }
+        inline void addItem(std::string_view label, Action &&action) {
+            items.push_back({ std::string(label), std::move(action) });
+        }
+
+        // items are kept until the next open, so their storage is reused
+        void clear();
+        void show(SDL_Point pos, const SDL_Rect &bounds, TTF_Font *font);
+        inline void close() { open = false; }
+        // true if consumed, any click closes the menu
+        bool handleEvent(const SDL_Event &event);
+        void draw(Graphics &g, TTF_Font *font, int bgcolor, int textcolor, int hlcolor) const;
     };
 
     class Component;
 
     class Window {
+    public:
+        using Task = std::function<void()>;
+        using Poller = std::function<bool()>;
+        using PresentHook = std::function<void(const SDL_Rect &)>;
     private:
         using CompMap = std::unordered_map<std::string_view, std::unique_ptr<Component>>;
         enum class State { INIT, RUN, EXIT };
 
+        static Uint32 taskEvent;
+
         int w, h;
         std::string_view title;
+        std::mutex taskMutex{};
+        std::vector<Task> tasks{}, deferred{};
+        // a task event is in SDL's queue, guarded by taskMutex
+        bool taskQueued = false;
+        std::vector<std::pair<int, Poller>> pollers{};
+        // while runPollers is looping, removed pollers get id -1 and new ones wait in addedPollers
+        std::vector<std::pair<int, Poller>> addedPollers{};
+        bool polling = false;
+        int nextPollerId = 0;
+        std::vector<std::pair<int, PresentHook>> presentHooks{};
+        int nextPresentHookId = 0;
+        struct Timer {
+            int id;
+            Uint32 due, interval;
+            Task task;
+        };
+        std::vector<Timer> timers{};
+        int nextTimerId = 0;
+        // one tooltip and one hover timer for the whole window
+        int hoverTimer = -1;
+        SDL_Point mouse{};
+        std::string tipText{};
+        SDL_Rect tipRect{};
+        ContextMenu menu{};
+        Component *modal{};
         CompMap components{};
         State state = State::INIT;
+        bool headless;
+        // taken before SDL starts up
+        Uint64 startTicks;
         Graphics g;
         TTF_Font *winfont;
         bool pendingUpdate = true;
+        SDL_Rect damage{};
+        bool windowShown = true, hasFocus = true;
+        double firstFrameMs = -1;
+        int unfocusedFps = 15, hiddenFps = 0;
+        // loop period while presentation is suspended, logic keeps running
+        static constexpr Uint32 suspendedTick = 100;
     public:
+        // a headless window has no SDL window and is drawn with renderFrame instead of run,
+        // on any thread as long as it stays on that thread
         Window(int width, int height, std::string_view title,
-            Font fontName = Font::CONSOLAS, int fontSize = 14);
+            Font fontName = Font::CONSOLAS, int fontSize = 14, bool headless = false);
 
         inline const Graphics &graphics() const { return g; }
+        // from the active Preloader's or this window's construction, negative until presented
+        inline double timeToFirstFrame() const { return firstFrameMs; }
         inline TTF_Font *font() const { return winfont; }
 
         Component *addComponent(std::unique_ptr<Component> &&comp, std::string_view id);
         inline Component *getComponent(std::string_view id) const {
             return components.count(id) ? components.at(id).get() : nullptr;
         }
+        template <typename F>
+        inline void forEachComponent(F f) const {
+            for (auto &[id, comp] : components) f(id, *comp);
+        }
+        // thread-safe, the task runs on the UI thread before the next redraw
+        void post(Task &&task);
+        // UI thread only, the task runs once after the current batch of events
+        inline void defer(Task &&task) { deferred.push_back(std::move(task)); }
+        // UI thread only, called once per frame, returning true requests a redraw
+        int addPoller(Poller &&poll);
+        void removePoller(int id);
+        // UI thread only, called after every present with the region that reached the screen
+        int addPresentHook(PresentHook &&hook);
+        void removePresentHook(int id);
+        // UI thread only, fires after delay ms, then every delay ms if repeat
+        int addTimer(Uint32 delay, Task &&task, bool repeat = false);
+        // moves the deadline to now + delay, false if the timer already fired or was cancelled
+        bool restartTimer(int id, Uint32 delay);
+        void cancelTimer(int id);
+        // tooltip delay in ms and overlay colors, shared by all components
+        Uint32 tooltipDelay = 600;
+        int tooltipBg = 0xFFFFE1, tooltipText = 0x202020;
+        int menuBg = 0x2D2D30, menuText = 0xF0F0F0, menuHL = 0x3E6DB5;
+        inline ContextMenu &contextMenu() { return menu; }
+        // while set, only this component gets input and it is drawn above the others
+        inline void setModal(Component *comp) { modal = comp; pendingUpdate = true; }
+        inline Component *getModal() const { return modal; }
+        // frame rates while unfocused and while hidden or minimized, 0 suspends presentation
+        inline void setBackgroundRates(int unfocused, int hidden = 0) {
+            unfocusedFps = unfocused;
+            hiddenFps = hidden;
+        }
+        inline bool isThrottled() const { return !windowShown || !hasFocus; }
+        // full redraw on the next frame
+        inline void invalidate() { pendingUpdate = true; }
+        // redraw and upload only this region on the next frame
+        void invalidate(const SDL_Rect &region);
         void run();
+        // runs pending tasks, deferred tasks, pollers and timers once and draws everything,
+        // the returned surface is the window's own screen
+        SDL_Surface *renderFrame();
+        // drops every component with the deferred tasks and timers that may refer to them
+        void clearComponents();
 
-        virtual ~Window() {}
+        virtual ~Window();
     private:
+        void runTasks();
+        void runDeferred();
+        void runPollers();
+        void runTimers();
+        inline int backgroundFps() const { return windowShown ? unfocusedFps : hiddenFps; }
+        inline bool presenting() const { return !isThrottled() || backgroundFps() > 0; }
+        Uint32 frameDelay() const;
+        void windowEvent(const SDL_WindowEvent &event);
         void events();
+        // the modal component's subtree while there is one, otherwise all components
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) const;
+        void hover(SDL_Point pos);
+        void showTooltip();
+        void hideTooltip();
+        bool overlayEvent(const SDL_Event &event);
+        void drawOverlay();
+        void presented(const SDL_Rect &region);
         void draw();
         void update();
+        void updateRegion(const SDL_Rect &region);
         bool handleEvent(const SDL_Event &event);
     };
 
@@ -118,12 +526,16 @@ namespace sdlw {
 
     class Component {
     public:
-        enum EventStatus { IGNORED, HANDLED, FORWARDED };
+        // HANDLED_PARTIAL: handled, and the component invalidated the regions it changed
+        enum EventStatus { IGNORED, HANDLED, FORWARDED, HANDLED_PARTIAL };
     protected:
         SDL_Rect rect;
         CompColors colors{};
         Window *win{};
         bool hovered = false, shown = true;
+        // not owned, must outlive the component
+        std::string_view tooltip{};
+        std::function<void(ContextMenu &)> menuBuilder{};
     public:
         CompColors rawColors;
 
@@ -138,6 +550,16 @@ namespace sdlw {
         inline bool isVisible() const { return shown; }
 
         inline bool posInside(SDL_Point pos) const { return SDL_PointInRect(&pos, &rect); }
+        inline std::string_view getTooltip() const { return tooltip; }
+        inline void setTooltip(std::string_view text) { tooltip = text; }
+        inline bool hasContextMenu() const { return bool(menuBuilder); }
+        // called on right-click to fill the window's shared menu
+        inline void setContextMenu(std::function<void(ContextMenu &)> &&build) { menuBuilder = std::move(build); }
+        inline void buildContextMenu(ContextMenu &menu) const { menuBuilder(menu); }
+        // deepest visible component under pos that satisfies accept, or nullptr
+        virtual Component *componentAt(SDL_Point pos, bool (*accept)(const Component &));
+        // the current value as text, as reported to automation clients
+        inline virtual std::string valueText() const { return {}; }
 
         inline void show() { shown = true; }
         inline void hide() { shown = false; }
@@ -164,9 +586,10 @@ namespace sdlw {
         EventStatus multihandleEvent(const SDL_Event &event, T& iterable) {
             EventStatus status = IGNORED;
             for (auto &elem : iterable) {
-                switch (elem->handleEvent(event)) {
+                switch (auto st = elem->handleEvent(event)) {
                 case HANDLED:
-                    return HANDLED;
+                case HANDLED_PARTIAL:
+                    return st;
                 case FORWARDED:
                     status = FORWARDED;
                     break;
@@ -179,6 +602,163 @@ namespace sdlw {
         }
     };
 
+    struct ListChange {
+        enum Kind { INSERTED, REMOVED, MOVED, CHANGED, RESET };
+
+        Kind kind;
+        int first, count, to = 0;
+
+        // position of a pre-change index after the change, -1 if it is gone
+        inline int remap(int index) const {
+            switch (kind) {
+            case INSERTED:
+                return index >= first ? index + count : index;
+            case REMOVED:
+                if (index < first) return index;
+                return index >= first + count ? index - count : -1;
+            case MOVED:
+                if (index >= first && index < first + count)
+                    return to + (index - first);
+                if (to < first && index >= to && index < first)
+                    return index + count;
+                if (to > first && index >= first + count && index < to + count)
+                    return index - count;
+                return index;
+            case RESET:
+                return -1;
+            default:
+                return index;
+            }
+        }
+    };
+
+    template <typename... Args>
+    class Signal {
+    public:
+        using Listener = std::function<void(Args...)>;
+    private:
+        std::vector<std::pair<int, Listener>> listeners{};
+        int nextId = 0;
+    public:
+        inline int subscribe(Listener &&listener) {
+            listeners.emplace_back(nextId, std::move(listener));
+            return nextId++;
+        }
+        inline void unsubscribe(int id) {
+            listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                [id](const auto &l) { return l.first == id; }), listeners.end());
+        }
+        void emit(Args... args) const {
+            for (std::size_t i = 0; i < listeners.size(); ++i)
+                listeners[i].second(args...);
+        }
+    };
+
+    template <typename T>
+    class ListModel {
+    public:
+        using Listener = Signal<const ListChange &>::Listener;
+    private:
+        std::vector<T> items{};
+        Signal<const ListChange &> changed{};
+    public:
+        ListModel() = default;
+        explicit ListModel(std::vector<T> &&items) : items(std::move(items)) {}
+
+        inline int size() const { return (int)items.size(); }
+        inline bool empty() const { return items.empty(); }
+        inline const T &operator[](int index) const { return items[index]; }
+        inline const std::vector<T> &data() const { return items; }
+
+        inline int subscribe(Listener &&listener) { return changed.subscribe(std::move(listener)); }
+        inline void unsubscribe(int id) { changed.unsubscribe(id); }
+        // subscription that ends when the returned function is called
+        static std::function<void()> observe(std::shared_ptr<ListModel> model, Listener &&listener) {
+            const int id = model->subscribe(std::move(listener));
+            return [model = std::move(model), id] { model->unsubscribe(id); };
+        }
+
+        template <typename It>
+        void insert(int pos, It begin, It end) {
+            const int count = (int)std::distance(begin, end);
+            if (count <= 0) return;
+            items.insert(items.begin() + pos, begin, end);
+            notify({ ListChange::INSERTED, pos, count });
+        }
+        inline void insert(int pos, T item) {
+            items.insert(items.begin() + pos, std::move(item));
+            notify({ ListChange::INSERTED, pos, 1 });
+        }
+        inline void append(T item) { insert(size(), std::move(item)); }
+
+        void erase(int first, int count = 1) {
+            if (count <= 0) return;
+            items.erase(items.begin() + first, items.begin() + first + count);
+            notify({ ListChange::REMOVED, first, count });
+        }
+        // moves [first, first + count) so that it starts at index "to" afterwards
+        void move(int first, int count, int to) {
+            if (count <= 0 || first == to) return;
+            if (to < first)
+                std::rotate(items.begin() + to, items.begin() + first, items.begin() + first + count);
+            else
+                std::rotate(items.begin() + first, items.begin() + first + count, items.begin() + to + count);
+            notify({ ListChange::MOVED, first, count, to });
+        }
+        inline void set(int index, T item) {
+            items[index] = std::move(item);
+            notify({ ListChange::CHANGED, index, 1 });
+        }
+        template <typename F>
+        void update(int first, int count, F &&fn) {
+            for (int i = first; i < first + count; ++i)
+                fn(items[i]);
+            notify({ ListChange::CHANGED, first, count });
+        }
+        void assign(std::vector<T> &&newItems) {
+            items = std::move(newItems);
+            notify({ ListChange::RESET, 0, size() });
+        }
+    private:
+        inline void notify(const ListChange &change) { changed.emit(change); }
+    };
+
+    // Value whose listeners are called at most once per frame with the latest value.
+    // Must be owned by a std::shared_ptr and used on the UI thread.
+    template <typename T>
+    class Observable : public std::enable_shared_from_this<Observable<T>> {
+    public:
+        using Listener = typename Signal<const T &>::Listener;
+    private:
+        Window *win;
+        T val;
+        bool scheduled = false;
+        Signal<const T &> changed{};
+    public:
+        Observable(Window &window, T init = T{}) : win(&window), val(std::move(init)) {}
+
+        inline const T &get() const { return val; }
+        void set(T newVal) {
+            if (newVal == val) return;
+            val = std::move(newVal);
+            if (scheduled) return;
+            scheduled = true;
+            win->defer([self = this->weak_from_this()] {
+                if (auto obs = self.lock()) {
+                    obs->scheduled = false;
+                    obs->changed.emit(obs->val);
+                }
+            });
+        }
+
+        inline int subscribe(Listener &&listener) { return changed.subscribe(std::move(listener)); }
+        inline void unsubscribe(int id) { changed.unsubscribe(id); }
+        static std::function<void()> observe(std::shared_ptr<Observable> obs, Listener &&listener) {
+            const int id = obs->subscribe(std::move(listener));
+            return [obs = std::move(obs), id] { obs->unsubscribe(id); };
+        }
+    };
+
     class Panel : public Component {
     public:
         using CompVec = std::vector<std::unique_ptr<Component>>;
@@ -195,6 +775,7 @@ namespace sdlw {
         virtual void draw(Graphics &g) override;
         virtual void translate(int x, int y) override;
         void setWindow(Window *window) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
 
         virtual Component *addComponent(std::unique_ptr<Component> &&comp);
         inline Component *getComponent(std::size_t index) const {
@@ -205,10 +786,49 @@ namespace sdlw {
         }
     };
 
-    class ScrollPanel : public Panel {
+    // Item-based scroll position, used by ScrollBar.
+    class Scrollable {
+    public:
+        virtual int scrollTotal() const = 0;
+        virtual int scrollPage() const = 0;
+        virtual int scrollPos() const = 0;
+        // clamps, and must not depend on the distance scrolled
+        virtual void scrollTo(int pos) = 0;
+
+        virtual ~Scrollable() {}
+    };
+
+    class ScrollBar : public Component {
+    private:
+        Scrollable *target;
+        bool dragging = false;
+        int grabOffset = 0;
+    public:
+        static constexpr int minThumb = 12;
+
+        ScrollBar(SDL_Rect rect, const CompColors &colors, Scrollable *target) :
+            Component(rect, colors), target(target) {}
+
+        inline void setTarget(Scrollable *t) { target = t; }
+        SDL_Rect thumbRect() const;
+        // scrolls so that the thumb is centered on screen coordinate y
+        void jumpTo(int y);
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        int posAt(int thumbY) const;
+    };
+
+    class ScrollPanel : public Panel, public Scrollable {
+    public:
+        using RowBuilder = std::function<CompVec(int, int)>;
     private:
         int index = 0, numShown;
         SDL_Point scrollBegin;
+        std::vector<Component *> visible{};
+        std::function<void()> unbinder{};
+        std::unique_ptr<ScrollBar> bar{};
     public:
         ScrollPanel(SDL_Rect rect, int bgcolor, int linecolor,
             int numShown, SDL_Point scrollBegin) :
@@ -216,21 +836,118 @@ namespace sdlw {
             numShown(numShown), scrollBegin(scrollBegin) {}
         ScrollPanel(SDL_Rect rect, int bgcolor, int linecolor, int numShown) :
             ScrollPanel(rect, bgcolor, linecolor, numShown, { rect.x, rect.y }) {}
+        ~ScrollPanel() { unbind(); }
+
+        inline int scrollTotal() const override { return (int)comps.size(); }
+        inline int scrollPage() const override { return numShown; }
+        inline int scrollPos() const override { return index; }
+        inline void scrollTo(int pos) override { index = pos; refreshVisible(); }
+        // owned scrollbar along the right edge, 0 removes it
+        void showScrollbar(int width = 12);
 
         void translate(int x, int y) override;
+        void setWindow(Window *window) override;
 
         virtual EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
         Component *addComponent(std::unique_ptr<Component> &&comp) override;
 
+        // rows are built by factory(const T &) -> std::unique_ptr<Component>
+        template <typename T, typename Factory>
+        void bind(std::shared_ptr<ListModel<T>> model, Factory factory) {
+            RowBuilder build = [m = model.get(), factory](int first, int count) {
+                CompVec rows;
+                for (int i = first; i < first + count; ++i)
+                    rows.push_back(factory((*m)[i]));
+                return rows;
+            };
+            unbind();
+            applyChange({ ListChange::RESET, 0, model->size() }, build);
+            unbinder = ListModel<T>::observe(std::move(model),
+                [this, build](const ListChange &change) { applyChange(change, build); });
+        }
+        inline void unbind() { if (unbinder) { unbinder(); unbinder = nullptr; } }
+
+        void applyChange(const ListChange &change, const RowBuilder &build);
+        void insertRows(int pos, CompVec &&rows);
+        void removeRows(int first, int count);
+        void moveRows(int first, int count, int to);
+        void replaceRows(int first, CompVec &&rows);
+
         void scrollContent();
+        void refreshVisible();
+    private:
+        void prepareRows(CompVec &rows);
+        void hideVisible();
+        inline bool inWindow(int first, int last) const {
+            return first < index + numShown && last > index;
+        }
+    };
+
+    class ListView : public Panel, public Scrollable {
+    public:
+        using Callback = std::function<void(int, const std::string &)>;
+    private:
+        class Row : public Component {
+        private:
+            int slot;
+            ListView *list;
+        public:
+            Row(SDL_Rect rect, const CompColors &colors, int slot, ListView *parent) :
+                Component(rect, colors), slot(slot), list(parent) {}
+
+            virtual EventStatus handleEvent(const SDL_Event &event) override;
+            virtual void draw(Graphics &g) override;
+        };
+    private:
+        std::vector<std::string> items{};
+        int first = 0, selected = -1, numShown;
+        Callback onSelect{};
+    public:
+        ListView(SDL_Rect rect, const CompColors &colors, int numShown);
+
+        inline int itemCount() const { return (int)items.size(); }
+        inline const std::string &item(int index) const { return items[index]; }
+        inline int firstVisible() const { return first; }
+        inline int selection() const { return selected; }
+        inline int scrollTotal() const override { return itemCount(); }
+        inline int scrollPage() const override { return numShown; }
+        inline int scrollPos() const override { return first; }
+        inline void setCallback(Callback &&cb) { onSelect = std::move(cb); }
+        inline std::string valueText() const override { return selected < 0 ? std::string{} : items[selected]; }
+
+        void setItems(std::vector<std::string> &&newItems);
+        // keeps the scroll position, the selection is set without notifying
+        void updateItems(std::vector<std::string> &&newItems, int newSelection);
+        void scrollTo(int index) override;
+        void moveSelection(int delta);
+        void select(int index);
+
+        virtual EventStatus handleEvent(const SDL_Event &event) override;
     };
 
     class Text : public Component {
+    private:
+        std::function<void()> unbinder{};
     public:
         std::string text{};
 
         Text(SDL_Rect rect, std::string_view text, int color) :
             Component(rect, { 0,0,color }), text(text) {}
+        ~Text() { unbind(); }
+
+        template <typename T, typename Format>
+        void bind(std::shared_ptr<Observable<T>> obs, Format format) {
+            unbind();
+            text = format(obs->get());
+            unbinder = Observable<T>::observe(std::move(obs),
+                [this, format](const T &val) { text = format(val); });
+        }
+        inline void bind(std::shared_ptr<Observable<std::string>> obs) {
+            bind(std::move(obs), [](const std::string &val) { return val; });
+        }
+        inline void unbind() { if (unbinder) { unbinder(); unbinder = nullptr; } }
+        inline std::string valueText() const override { return text; }
 
         virtual inline EventStatus handleEvent(const SDL_Event &event) override {
             return EventStatus::IGNORED;
@@ -255,6 +972,7 @@ namespace sdlw {
             Component(rect, colors), text(text), callback(callback) {}
 
         inline void setCallback(Callback &&cb) { callback = std::move(cb); }
+        inline std::string valueText() const override { return text; }
 
         virtual EventStatus handleEvent(const SDL_Event &event) override;
         virtual void draw(Graphics &g) override;
@@ -273,12 +991,14 @@ namespace sdlw {
             std::unique_ptr<Panel> &&panel, ExpandDir expDir = ExpandDir::DOWN);
 
         inline Panel *getPanel() { return panel.get(); }
+        inline std::string valueText() const override { return text; }
 
         inline void setExpanded(bool val) { panel->setVisibility(expanded = val); }
         inline void toggleExpanded() { setExpanded(!expanded); }
         void setExpandDir(ExpandDir dir);
         virtual void setWindow(Window *window) override;
         void translate(int x, int y) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
 
         virtual EventStatus handleEvent(const SDL_Event &event) override;
         virtual void draw(Graphics &g) override;
@@ -302,29 +1022,47 @@ namespace sdlw {
                 Component(rect, colors), ind(index), text(text), comboBox(parent) {}
 
             inline int index() const { return ind; }
+            inline void setIndex(int index) { ind = index; }
 
             virtual EventStatus handleEvent(const SDL_Event &event) override;
             virtual void draw(Graphics &g) override;
         };
     private:
         int index = 0;
-        std::vector<std::string_view> options;
+        std::vector<std::string> options;
+        std::function<void()> unbinder{}, selUnbinder{};
+        std::shared_ptr<Observable<int>> boundSel{};
     public:
         ComboBox(SDL_Rect rect, const std::vector<std::string_view> &options,
             const CompColors &colors, int numShown, ExpandDir expDir = ExpandDir::DOWN) :
-            Expandable(rect, options[0], colors, makePanel(numShown), expDir),
-            options(options) {
+            Expandable(rect, options.empty() ? "" : options[0], colors, makePanel(numShown), expDir),
+            options(options.begin(), options.end()) {
             if (win) finalizePanel();
         }
+        ~ComboBox() { unbind(); unbindSelection(); }
 
         inline int currentIndex() const { return index; }
-        inline std::string_view currentText() const { return options[index]; }
+        inline std::string_view currentText() const {
+            return options.empty() ? std::string_view{} : options[index];
+        }
 
-        inline void setSelection(int ind) { index = ind; text = options[ind]; }
+        inline void setSelection(int ind) {
+            index = ind; text = options[ind];
+            if (boundSel) boundSel->set(ind);
+        }
         void setWindow(Window *window) override;
+
+        void bind(std::shared_ptr<ListModel<std::string>> model);
+        void bind(std::shared_ptr<Observable<int>> selection);
+        inline void unbind() { if (unbinder) { unbinder(); unbinder = nullptr; } }
+        inline void unbindSelection() {
+            if (selUnbinder) { selUnbinder(); selUnbinder = nullptr; }
+            boundSel = nullptr;
+        }
     private:
         std::unique_ptr<ScrollPanel> makePanel(int numShown);
         void finalizePanel();
+        void applyChange(const ListChange &change, const ListModel<std::string> &model);
     };
 
     class Slider : public Component {
@@ -337,6 +1075,8 @@ namespace sdlw {
         SDL_Rect sliderRect;
         SDL_Point mousePos{};
         Callback onValChange{};
+        std::function<void()> unbinder{};
+        std::shared_ptr<Observable<int>> bound{};
     public:
         Slider(SDL_Rect rect, int min, int max,
             int step, const CompColors &colors,
@@ -344,6 +1084,7 @@ namespace sdlw {
             Component(rect, colors), min(min), max(max),
             step(step), val(float(min)), vertical(vertic),
             sliderRect(makeSliderRect(slidRectWidth)) {}
+        ~Slider() { unbind(); }
 
         inline int trueVal() const { return stepn() * step + min; }
         inline int stepn() const { return static_cast<int>(std::round((val - min) / step)); }
@@ -351,6 +1092,9 @@ namespace sdlw {
             return vertical ? h() - sliderRect.h : w() - sliderRect.w;
         }
         inline std::string str() const { return std::to_string(trueVal()); }
+        inline SDL_Rect thumbRect() const { return sliderRect; }
+        inline bool isDragging() const { return dragging; }
+        inline std::string valueText() const override { return str(); }
 
         inline void setCallback(Callback &&cb) { cb(trueVal()); onValChange = cb; }
         inline void setVal(int newVal) { val = float(newVal); dragDiff({ 0,0 }); }
@@ -359,8 +1103,15 @@ namespace sdlw {
         }
         void translate(int x, int y) override;
 
+        void bind(std::shared_ptr<Observable<int>> obs);
+        inline void unbind() {
+            if (unbinder) { unbinder(); unbinder = nullptr; }
+            bound = nullptr;
+        }
+
         EventStatus handleEvent(const SDL_Event &event) override;
         void draw(Graphics &g) override;
+        void drawThumb(Graphics &g);
     private:  
         // pixels per step
         inline float pps() const { return 1.f * valPxCount() / (max - min) * step; }
@@ -377,30 +1128,51 @@ namespace sdlw {
     public:
         using Callback = std::function<void(const std::string &)>;
     private:
-        std::string text;
+        std::string text, pending{};
         int caretPos{};
         bool active = false, autoHide;
-        Callback onConfirm{};
+        Callback onConfirm{}, onChange{};
+        std::function<void()> unbinder{};
+        std::shared_ptr<Observable<std::string>> bound{};
     public:
         TextInput(SDL_Rect rect, const CompColors &colors,
             std::string_view initVal = "", bool autoHide = false) :
             Component(rect, colors), text(initVal), autoHide(autoHide) {
             if (autoHide) hide();
         }
+        ~TextInput() { unbind(); }
 
         void activate();
         void deactivate();
-        inline void clear() { text = ""; caretPos = 0; }
+        inline void clear() { text = ""; pending = ""; caretPos = 0; }
         inline void setAutoHide(bool val = true) { autoHide = val; }
         inline void setCallback(Callback &&cb) { onConfirm = std::move(cb); }
+        inline void setChangeCallback(Callback &&cb) { onChange = std::move(cb); }
+        inline bool isActive() const { return active; }
+        inline const std::string &value() { commitPending(); return text; }
+        inline std::string valueText() const override {
+            return pending.empty() ? text : std::string(text).insert(caretPos, pending);
+        }
+        void setValue(std::string_view val);
+
+        void bind(std::shared_ptr<Observable<std::string>> obs);
+        inline void unbind() {
+            if (unbinder) { unbinder(); unbinder = nullptr; }
+            bound = nullptr;
+        }
 
         EventStatus handleEvent(const SDL_Event &event) override;
         void draw(Graphics &g) override;
 
         void insertChar(char chr, std::size_t index);
+        void insertText(std::string_view str, std::size_t index);
         void deleteChar(std::size_t index);
+        void paste();
     private:
         bool handleKey(int kp);
+        void commitPending();
+        void notifyChange();
+        int charBoundary(int pos, int dir) const;
     };
 
     class ColorSelect : public Expandable {
@@ -419,6 +1191,7 @@ namespace sdlw {
         void setColor(Color color);
         bool setColor(const std::string &hexStr);
         void setWindow(Window *window) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
 
         EventStatus handleEvent(const SDL_Event &event) override;
         void draw(Graphics &g) override;
@@ -442,6 +1215,7 @@ namespace sdlw {
 
             void translate(int x, int y) override;
             void setWindow(Window *window) override;
+            Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
 
             EventStatus handleEvent(const SDL_Event &event) override;
             void draw(Graphics &g) override;
@@ -457,10 +1231,17 @@ namespace sdlw {
         std::unique_ptr<Button> addButton{};
         short flags{};
         Panel::CompVec &elems;
+        std::function<void()> unbinder{};
+        // forwards delete/swap requests to the bound model
+        std::function<void(const ListChange &)> modelEdit{};
+        // the add button appends to the bound model instead of using addFactory
+        std::function<void()> modelAdd{};
+        FactoryCallback addFactory{};
     public:
         Dropdown(SDL_Rect rect, SDL_Rect elemRect, std::string_view text,
             short flags, int numShown, const CompColors &colors,
             ExpandDir expDir = ExpandDir::DOWN);
+        ~Dropdown() { unbind(); }
 
         Component *addComponent(std::unique_ptr<Component> &&comp);
         void removeAt(int index);
@@ -468,10 +1249,810 @@ namespace sdlw {
         void setWindow(Window *window) override;
         void setFactory(FactoryCallback &&fcb);
 
+        // rows are built by factory(const T &) -> std::unique_ptr<Component>, the add
+        // button appends newItem(size), or T{} without it
+        template <typename T, typename Factory>
+        void bind(std::shared_ptr<ListModel<T>> model, Factory factory,
+            std::function<T(int)> newItem = nullptr) {
+            ScrollPanel::RowBuilder build = [m = model.get(), factory](int first, int count) {
+                Panel::CompVec rows;
+                for (int i = first; i < first + count; ++i)
+                    rows.push_back(factory((*m)[i]));
+                return rows;
+            };
+            unbind();
+            applyChange({ ListChange::RESET, 0, model->size() }, build);
+            modelEdit = [m = model.get()](const ListChange &edit) {
+                if (edit.kind == ListChange::REMOVED)
+                    m->erase(edit.first, edit.count);
+                else if (edit.kind == ListChange::MOVED)
+                    m->move(edit.first, edit.count, edit.to);
+            };
+            modelAdd = [m = model.get(), newItem = std::move(newItem)] {
+                if (newItem)
+                    m->append(newItem(m->size()));
+                else if constexpr (std::is_default_constructible_v<T>)
+                    m->append(T{});
+            };
+            unbinder = ListModel<T>::observe(std::move(model),
+                [this, build](const ListChange &change) { applyChange(change, build); });
+        }
+        inline void unbind() {
+            if (unbinder) { unbinder(); unbinder = nullptr; }
+            modelEdit = nullptr;
+            modelAdd = nullptr;
+        }
+
         EventStatus handleEvent(const SDL_Event &event) override;
         void draw(Graphics &g) override;
     private:
         std::unique_ptr<ScrollPanel> makePanel(const SDL_Rect &rect, int numShown);
+        std::unique_ptr<MiniPanel> wrap(std::unique_ptr<Component> &&comp);
+        inline ScrollPanel *scrollPanel() { return static_cast<ScrollPanel *>(panel.get()); }
+        void applyChange(const ListChange &change, const ScrollPanel::RowBuilder &build);
         void reindex(int from = 0);
     };
+
+    class PrefixIndex {
+    private:
+        std::vector<std::string> keys;
+    public:
+        using CancelCheck = std::function<bool()>;
+
+        PrefixIndex() = default;
+        explicit PrefixIndex(std::vector<std::string> &&keys);
+
+        inline std::size_t size() const { return keys.size(); }
+
+        std::vector<std::string> query(std::string_view prefix, std::size_t limit,
+            const CancelCheck &cancelled = {}) const;
+    };
+
+    class AutoComplete : public Expandable {
+    private:
+        struct Lookup;
+
+        std::unique_ptr<TextInput> input;
+        std::shared_ptr<Lookup> lookup;
+    public:
+        AutoComplete(SDL_Rect rect, const CompColors &colors,
+            std::shared_ptr<const PrefixIndex> index, int numShown,
+            std::size_t maxResults = 1000, ExpandDir expDir = ExpandDir::DOWN);
+        ~AutoComplete();
+
+        inline TextInput *getInput() { return input.get(); }
+        inline ListView *getList() { return static_cast<ListView *>(panel.get()); }
+
+        void setIndex(std::shared_ptr<const PrefixIndex> index);
+        void setWindow(Window *window) override;
+        void translate(int x, int y) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        static std::unique_ptr<ListView> makePanel(const SDL_Rect &rect, const CompColors &colors, int numShown);
+        void requestLookup(const std::string &prefix);
+        void showSuggestions(std::vector<std::string> &&found);
+        void accept(int index);
+    };
+
+    // Single-writer sequence lock, readers never block the writer nor each other.
+    template <typename T>
+    class SeqLock {
+        static_assert(std::is_trivially_copyable_v<T>, "SeqLock needs a trivially copyable type");
+    private:
+        static constexpr std::size_t words = (sizeof(T) + 7) / 8;
+
+        std::atomic<unsigned> seq{ 0 };
+        std::atomic<std::uint64_t> data[words]{};
+    public:
+        SeqLock(const T &init = T{}) { store(init); }
+
+        void store(const T &val) {
+            std::uint64_t buf[words]{};
+            std::memcpy(buf, &val, sizeof(T));
+            const unsigned s = seq.load(std::memory_order_relaxed);
+            seq.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < words; ++i)
+                data[i].store(buf[i], std::memory_order_relaxed);
+            seq.store(s + 2, std::memory_order_release);
+        }
+        T load() const {
+            std::uint64_t buf[words];
+            unsigned s1, s2;
+            do {
+                s1 = seq.load(std::memory_order_acquire);
+                for (std::size_t i = 0; i < words; ++i)
+                    buf[i] = data[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                s2 = seq.load(std::memory_order_relaxed);
+            } while ((s1 & 1) || s1 != s2);
+            T val;
+            std::memcpy(&val, buf, sizeof(T));
+            return val;
+        }
+    };
+
+    // Samples a value source once per frame and redraws only when the shown value changes.
+    class Gauge : public Component {
+    public:
+        using Source = std::function<double()>;
+    protected:
+        Source source{};
+        double shownVal = 0;
+        int pollId = -1;
+    public:
+        Gauge(SDL_Rect rect, const CompColors &colors) : Component(rect, colors) {}
+        ~Gauge();
+
+        inline double value() const { return shownVal; }
+        inline std::string valueText() const override { return std::to_string(shownVal); }
+        inline void setSource(Source &&src) { source = std::move(src); sample(); }
+
+        template <typename T>
+        void bind(const std::atomic<T> &val) {
+            setSource([&val] { return double(val.load(std::memory_order_relaxed)); });
+        }
+        template <typename T, typename Proj>
+        void bind(const SeqLock<T> &lock, Proj proj) {
+            setSource([&lock, proj] { return double(proj(lock.load())); });
+        }
+
+        void setWindow(Window *window) override;
+
+        inline EventStatus handleEvent(const SDL_Event &event) override { return IGNORED; }
+    protected:
+        // the sampled value as it would be displayed, equal keys skip the redraw
+        virtual long long displayKey(double val) const = 0;
+        // returns whether the whole window needs a redraw
+        inline virtual bool valueChanged() { return true; }
+        bool sample();
+    };
+
+    class ProgressBar : public Gauge {
+    private:
+        double min, max;
+        bool showText;
+    public:
+        ProgressBar(SDL_Rect rect, const CompColors &colors,
+            double min = 0., double max = 1., bool showText = true) :
+            Gauge(rect, colors), min(min), max(max), showText(showText) {}
+
+        inline double fraction() const {
+            return max > min ? std::clamp((shownVal - min) / (max - min), 0., 1.) : 0.;
+        }
+
+        void draw(Graphics &g) override;
+    protected:
+        long long displayKey(double val) const override;
+    };
+
+    class ValueLabel : public Gauge {
+    private:
+        int precision;
+        std::string suffix;
+    public:
+        ValueLabel(SDL_Rect rect, int color, int precision = 0, std::string_view suffix = "") :
+            Gauge(rect, { 0,0,color }), precision(precision), suffix(suffix) {}
+
+        void draw(Graphics &g) override;
+    protected:
+        long long displayKey(double val) const override;
+    };
+
+    // Counter drawn from cached glyphs in fixed-width, right-aligned cells.
+    class NumericLabel : public Gauge {
+    public:
+        static constexpr int capacity = 32;
+    private:
+        char buf[capacity]{}, drawn[capacity]{};
+        int len = 0, drawnLen = 0, precision, cellW = 0;
+    public:
+        NumericLabel(SDL_Rect rect, int color, int precision = 0) :
+            Gauge(rect, { 0,0,color }), precision(precision) { format(); }
+
+        void setValue(double val);
+
+        void draw(Graphics &g) override;
+    protected:
+        long long displayKey(double val) const override;
+        bool valueChanged() override;
+    private:
+        void format();
+        SDL_Rect cellRect(int fromRight) const;
+    };
+
+    // 256-entry ARGB8888 lookup table
+    class Colormap {
+    private:
+        std::array<Uint32, 256> lut{};
+    public:
+        Colormap();
+        explicit Colormap(const std::array<Uint32, 256> &lut) : lut(lut) {}
+
+        // evenly spaced 0xRRGGBB stops, linearly interpolated
+        static Colormap gradient(std::initializer_list<int> stops);
+
+        inline Uint32 operator[](int index) const { return lut[index]; }
+        inline const Uint32 *data() const { return lut.data(); }
+    };
+
+    class Heatmap : public Component {
+    public:
+        enum class Filter { NEAREST, BILINEAR };
+    private:
+        int cols, rows, threads = 1;
+        float lo, hi;
+        Colormap cmap;
+        Filter filter;
+        SDL_Surface *cells{}, *scaled{};
+    public:
+        Heatmap(SDL_Rect rect, int cols, int rows, const Colormap &cmap,
+            float lo = 0.f, float hi = 1.f, Filter filter = Filter::NEAREST);
+        Heatmap(const Heatmap &) = delete;
+        ~Heatmap();
+
+        inline int columns() const { return cols; }
+        inline int rowCount() const { return rows; }
+        // the next setData/updateRows uses the new mapping
+        inline void setRange(float low, float high) { lo = low; hi = high; }
+        inline void setColormap(const Colormap &map) { cmap = map; }
+        inline void setThreads(int n) { threads = std::max(1, n); }
+        void setFilter(Filter f);
+
+        // stride is in elements between the starts of consecutive rows
+        void setData(const float *data, std::ptrdiff_t stride);
+        void setData(const Uint16 *data, std::ptrdiff_t stride);
+        // data points at the first updated row
+        void updateRows(const float *data, std::ptrdiff_t stride, int firstRow, int count);
+        void updateRows(const Uint16 *data, std::ptrdiff_t stride, int firstRow, int count);
+
+        inline EventStatus handleEvent(const SDL_Event &event) override { return IGNORED; }
+        void draw(Graphics &g) override;
+    private:
+        template <typename T>
+        void convert(const T *data, std::ptrdiff_t stride, int firstRow, int count);
+        void resample(int firstRow, int count);
+        SDL_Rect screenRows(int firstRow, int count) const;
+    };
+
+    // Scrolling history of rows kept in a ring buffer surface, appending converts a single row.
+    class Waterfall : public Component {
+    private:
+        int cols, history, head = 0;
+        float lo, hi;
+        bool newestOnTop;
+        Colormap cmap;
+        SDL_Surface *ring{};
+    public:
+        Waterfall(SDL_Rect rect, int cols, int history, const Colormap &cmap,
+            float lo = 0.f, float hi = 1.f, bool newestOnTop = true);
+        Waterfall(const Waterfall &) = delete;
+        ~Waterfall();
+
+        inline void setRange(float low, float high) { lo = low; hi = high; }
+        void appendRow(const float *data);
+        void appendRow(const Uint16 *data);
+        void clear();
+
+        inline EventStatus handleEvent(const SDL_Event &event) override { return IGNORED; }
+        void draw(Graphics &g) override;
+    private:
+        template <typename T>
+        void append(const T *data);
+    };
+
+    // Retained surface that user code paints into incrementally, composited with one blit.
+    class Canvas : public Component {
+    public:
+        using PaintCallback = std::function<void(Painter &)>;
+    private:
+        SDL_Surface *backing{};
+        Painter painter{};
+        PaintCallback onPaint{};
+    public:
+        Canvas(SDL_Rect rect, int bgcolor = 0x000000);
+        Canvas(const Canvas &) = delete;
+        ~Canvas();
+
+        // draws in canvas coordinates, changes show up after markDirty
+        inline Painter &paint() { return painter; }
+        inline void setPaintCallback(PaintCallback &&cb) { onPaint = std::move(cb); repaint(); }
+        // clears to the background and runs the paint callback
+        void repaint();
+        void markDirty(const SDL_Rect &region);
+        inline void markDirty() { markDirty({ 0, 0, rect.w, rect.h }); }
+        void setWindow(Window *window) override;
+
+        inline EventStatus handleEvent(const SDL_Event &event) override { return IGNORED; }
+        void draw(Graphics &g) override;
+    };
+
+    struct SceneBounds {
+        float x, y, w, h;
+    };
+
+    // world -> screen mapping of a SceneCanvas, scale is pixels per world unit
+    struct SceneView {
+        float scale = 1.f, x = 0.f, y = 0.f;
+        SDL_Rect viewport{};
+
+        // clamped far outside any surface, so deep zoom cannot overflow an int
+        inline static int pixel(float v) {
+            constexpr float limit = float(1 << 28);
+            return (int)std::floor(std::clamp(v, -limit, limit));
+        }
+        inline SDL_Point toScreen(float wx, float wy) const {
+            return { viewport.x + pixel((wx - x) * scale), viewport.y + pixel((wy - y) * scale) };
+        }
+        inline SDL_Rect toScreen(const SceneBounds &b) const {
+            const SDL_Point p1 = toScreen(b.x, b.y), p2 = toScreen(b.x + b.w, b.y + b.h);
+            return { p1.x, p1.y, std::max(1, p2.x - p1.x), std::max(1, p2.y - p1.y) };
+        }
+        inline SceneBounds visibleWorld() const {
+            return { x, y, viewport.w / scale, viewport.h / scale };
+        }
+    };
+
+    class SceneItem {
+    public:
+        virtual SceneBounds bounds() const = 0;
+        // level of detail is up to the item, e.g. based on view.toScreen(bounds()) size
+        virtual void draw(Painter &p, const SceneView &view) = 0;
+
+        virtual ~SceneItem() {}
+    };
+
+    class BoxItem : public SceneItem {
+    public:
+        SceneBounds box;
+        int color, textColor;
+        std::string label;
+        TTF_Font *font;
+
+        BoxItem(SceneBounds box, int color, std::string_view label = "",
+            TTF_Font *font = nullptr, int textColor = 0xFFFFFF) :
+            box(box), color(color), textColor(textColor), label(label), font(font) {}
+
+        inline SceneBounds bounds() const override { return box; }
+        void draw(Painter &p, const SceneView &view) override;
+    };
+
+    // Pannable, zoomable view over many items, only items in visible grid cells are touched.
+    class SceneCanvas : public Component {
+    private:
+        struct Cells { int x0, y0, x1, y1; };
+        // items spanning more cells than this are kept out of the grid and always tested
+        static constexpr long long maxCells = 1024;
+
+        std::vector<std::unique_ptr<SceneItem>> items{};
+        std::vector<Cells> itemCells{};
+        std::vector<int> oversized{};
+        std::vector<unsigned> seenStamp{};
+        std::unordered_map<long long, std::vector<int>> grid{};
+        float cellSize, minScale = 1e-4f, maxScale = 1e4f;
+        float cullSize = 0.f;
+        unsigned stamp = 0;
+        SceneView view{};
+        bool panning = false;
+        SDL_Point mousePos{};
+    public:
+        SceneCanvas(SDL_Rect rect, int bgcolor, float cellSize = 256.f);
+
+        inline const SceneView &getView() const { return view; }
+        inline std::size_t itemCount() const { return items.size(); }
+        inline SceneItem *item(int index) const { return items[index].get(); }
+        inline void setScaleLimits(float lo, float hi) { minScale = lo; maxScale = hi; }
+        // items smaller than this many pixels on screen are skipped entirely
+        inline void setCullSize(float px) { cullSize = px; }
+
+        int addItem(std::unique_ptr<SceneItem> &&item);
+        // the last item takes over the removed item's index
+        void removeItem(int index);
+        // call after an item's bounds changed
+        void itemMoved(int index);
+        void clearItems();
+
+        void setView(float x, float y, float scale);
+        void panBy(int dx, int dy);
+        void zoomAt(SDL_Point screenPos, float factor);
+        void fitAll();
+
+        template <typename F>
+        void forEachVisible(F &&fn) {
+            const SceneBounds vis = view.visibleWorld();
+            const Cells range = cellsOf(vis);
+            const long long span = 1LL * (range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1);
+            ++stamp;
+            auto visit = [&](const std::vector<int> &cell) {
+                for (int index : cell) {
+                    if (seenStamp[index] == stamp) continue;
+                    seenStamp[index] = stamp;
+                    const SceneBounds b = items[index]->bounds();
+                    if (b.x > vis.x + vis.w || b.y > vis.y + vis.h
+                        || b.x + b.w < vis.x || b.y + b.h < vis.y)
+                        continue;
+                    fn(index, *items[index]);
+                }
+            };
+            // zoomed far out there may be fewer occupied cells than cells in view
+            if (span > (long long)grid.size()) {
+                for (const auto &[key, cell] : grid)
+                    visit(cell);
+            }
+            else {
+                for (int cy = range.y0; cy <= range.y1; ++cy)
+                    for (int cx = range.x0; cx <= range.x1; ++cx)
+                        if (auto it = grid.find(key(cx, cy)); it != grid.end())
+                            visit(it->second);
+            }
+            visit(oversized);
+        }
+
+        void translate(int x, int y) override;
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        inline static long long key(int cx, int cy) {
+            return (long long)cx << 32 | (Uint32)cy;
+        }
+        Cells cellsOf(const SceneBounds &b) const;
+        void insertCells(int index);
+        void removeCells(int index);
+    };
+
+    // Two-thumb slider over [min, max] with an optional histogram drawn above the track.
+    class RangeSlider : public Component {
+    public:
+        using Callback = std::function<void(int, int)>;
+    private:
+        Slider lower, upper;
+        int min, max, histH, lastLo, lastHi;
+        SDL_Surface *histo{};
+        std::thread worker{};
+        std::shared_ptr<std::atomic<bool>> cancelJob{};
+        std::shared_ptr<const std::vector<float>> pendingData{};
+        int pendingBins = 0;
+        Callback onChange{};
+    public:
+        RangeSlider(SDL_Rect rect, int min, int max, int step,
+            const CompColors &colors, int histHeight = 0, int thumbW = 10);
+        RangeSlider(const RangeSlider &) = delete;
+        ~RangeSlider();
+
+        inline int lowerVal() const { return lower.trueVal(); }
+        inline int upperVal() const { return upper.trueVal(); }
+        inline void setCallback(Callback &&cb) { onChange = std::move(cb); }
+        void setRange(int lo, int hi);
+        // binned off the UI thread, the data is kept alive until then
+        void setHistogram(std::shared_ptr<const std::vector<float>> data, int bins);
+
+        void translate(int x, int y) override;
+        void setWindow(Window *window) override;
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        inline SDL_Rect histRect() const { return { rect.x, rect.y - histH - 6, rect.w, histH }; }
+        SDL_Rect labelRect(const Slider &s) const;
+        SDL_Rect damageOf(const Slider &s) const;
+        // the highlighted track between the thumbs
+        inline SDL_Rect bandRect() const {
+            const SDL_Rect lt = lower.thumbRect(), ut = upper.thumbRect();
+            return { lt.x + lt.w / 2, rect.y, ut.x - lt.x, rect.h };
+        }
+        void startHistogram();
+        void buildHistogram(const std::vector<unsigned> &counts);
+        void stopWorker();
+    };
+
+    // Pages are built on first activation and can be destroyed again after being inactive for a while.
+    class Tabs : public Component {
+    public:
+        using PageFactory = std::function<std::unique_ptr<Panel>(SDL_Rect)>;
+    private:
+        struct Page {
+            std::string title;
+            PageFactory factory;
+            std::unique_ptr<Panel> panel{};
+            Uint32 lastActive = 0;
+        };
+
+        std::vector<Page> pages{};
+        int active = -1, tabH, pollId = -1;
+        Uint32 unloadAfter = 0, lastSweep = 0;
+    public:
+        Tabs(SDL_Rect rect, const CompColors &colors, int tabHeight = 30) :
+            Component(rect, colors), tabH(tabHeight) {}
+        ~Tabs();
+
+        inline int activeIndex() const { return active; }
+        inline std::size_t count() const { return pages.size(); }
+        // nullptr while the page is not built
+        inline Panel *page(int index) const { return pages[index].panel.get(); }
+        inline SDL_Rect pageRect() const { return { rect.x, rect.y + tabH, rect.w, rect.h - tabH }; }
+        inline std::string valueText() const override { return active < 0 ? std::string{} : pages[active].title; }
+        // 0 keeps built pages forever
+        inline void setUnloadAfter(Uint32 ms) { unloadAfter = ms; }
+
+        int addPage(std::string_view title, PageFactory &&factory);
+        void setActive(int index);
+
+        void translate(int x, int y) override;
+        void setWindow(Window *window) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        SDL_Rect tabRect(int index) const;
+        void unloadIdle();
+    };
+
+    // Two panes with a draggable divider. Dragging relays out live while layout and drawing
+    // fit the frame budget, otherwise it shows scaled snapshots until the mouse is released.
+    class Splitter : public Component {
+    public:
+        using Layout = std::function<void(int, Component &, SDL_Rect)>;
+    private:
+        std::unique_ptr<Component> panes[2]{};
+        SDL_Surface *snaps[2]{};
+        bool horizontal, dragging = false, cached = false, relaidOut = false;
+        int split, dividerW, minPane = 20;
+        double budgetMs = 8., layoutMs = 0., lastCostMs = 0.;
+        Layout layout{};
+    public:
+        Splitter(SDL_Rect rect, const CompColors &colors,
+            bool horizontal = true, int dividerW = 6);
+        Splitter(const Splitter &) = delete;
+        ~Splitter();
+
+        inline Component *pane(int index) const { return panes[index].get(); }
+        inline int splitPos() const { return split; }
+        inline std::string valueText() const override { return std::to_string(split); }
+        // called for each pane with its new rect, by default moves and resizes the pane itself
+        inline void setLayout(Layout &&fn) { layout = std::move(fn); relayout(); }
+        // 0 always drags with snapshots
+        inline void setFrameBudget(double ms) { budgetMs = ms; }
+        inline void setMinPane(int px) { minPane = px; }
+
+        Component *setPane(int index, std::unique_ptr<Component> &&comp);
+        void setSplit(int px);
+
+        void translate(int x, int y) override;
+        void setWindow(Window *window) override;
+        Component *componentAt(SDL_Point pos, bool (*accept)(const Component &)) override;
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+        void draw(Graphics &g) override;
+    private:
+        SDL_Rect paneRect(int index) const;
+        SDL_Rect dividerRect() const;
+        void relayout();
+        void snapshot();
+        void dropSnapshots();
+    };
+
+    // Modal file picker. The directory is enumerated on one background thread and
+    // filtered and sorted on another, the list is refreshed a few times per second.
+    class FilePicker : public Panel {
+    public:
+        // receives the chosen path, or an empty string on cancel
+        using Callback = std::function<void(const std::string &)>;
+        enum class SortBy { NAME, SIZE, MODIFIED };
+    private:
+        struct Worker;
+        static constexpr int rowH = 22, sortW = 64;
+
+        std::shared_ptr<Worker> worker;
+        std::string dir{}, chosen{};
+        Text *pathText, *statusText;
+        TextInput *filterInput;
+        ListView *list;
+        std::vector<Button *> sortButtons{};
+        SortBy sortBy = SortBy::NAME;
+        bool descending = false;
+        Callback onDone{};
+    public:
+        FilePicker(SDL_Rect rect, const CompColors &colors);
+        ~FilePicker();
+
+        inline const std::string &directory() const { return dir; }
+        inline void setCallback(Callback &&cb) { onDone = std::move(cb); }
+
+        // shows the dialog at once, entries stream in as they are read
+        void open(const std::string &path);
+        void setFilter(std::string_view text);
+        void setSort(SortBy by, bool desc = false);
+
+        EventStatus handleEvent(const SDL_Event &event) override;
+    private:
+        void showEntries(std::vector<std::string> &&names, int sel, std::size_t total, bool scanning);
+        void pick(const std::string &name);
+        void finish(bool accepted);
+    };
+
+    // One signed distance field atlas per font, rasterized once at a base size and
+    // drawn at any pixel size through a per-pixel threshold. Glyphs are added to
+    // the atlas on first use; the target must be a 32-bit surface.
+    class SdfFont {
+    private:
+        // cell in the atlas, padded by spread on every side
+        struct Glyph {
+            int x, y, w, h, advance;
+        };
+        static constexpr int atlasW = 512;
+
+        TTF_Font *font;
+        int baseSize, spread;
+        std::vector<Uint8> atlas{};
+        int atlasH = 0, penX = 0, penY = 0, shelfH = 0;
+        std::unordered_map<Uint32, Glyph> glyphs{};
+        bool frozen = false;
+    public:
+        SdfFont(Font fontName, int baseSize = 48, int spread = 6);
+        SdfFont(const SdfFont &) = delete;
+        SdfFont &operator=(const SdfFont &) = delete;
+        ~SdfFont();
+
+        inline bool isValid() const { return font != nullptr; }
+        inline int atlasHeight() const { return atlasH; }
+        inline float lineHeight(float px) const { return float(TTF_FontHeight(font)) * px / baseSize; }
+
+        // builds these glyphs now instead of on first draw
+        void preload(std::string_view text);
+        // no more glyphs are built, so the font can be drawn from several threads at once;
+        // characters that were not preloaded are skipped
+        inline void freeze() { frozen = true; }
+        float measure(std::string_view text, float px);
+        void draw(Painter &p, float x, float y, std::string_view text, float px, Color color);
+    private:
+        const Glyph *glyph(Uint32 cp);
+    };
+
+    // Streams the window's framebuffer to clients on a TCP ("host:port") or UNIX
+    // ("unix:/path") socket and turns their input into SDL events. Changed tiles
+    // are XORed against what the clients already have and run-length encoded on
+    // a background thread; the UI thread only copies the presented region.
+    // The Window must outlive the server.
+    class FrameServer {
+    public:
+        static constexpr int tileSize = 64;
+    private:
+        struct Client {
+            std::intptr_t sock;
+            std::atomic<bool> alive{ true };
+            // encoder thread only, the socket is non-blocking and outbox holds what it did not take
+            bool synced = false;
+            std::vector<Uint8> outbox{};
+            // partial input message, network thread only
+            std::vector<Uint8> input{};
+
+            explicit Client(std::intptr_t sock) : sock(sock) {}
+            // closed with the last reference, so no thread sends on a reused descriptor
+            ~Client();
+        };
+
+        Window &win;
+        int w, h;
+        std::string unixPath{};
+        std::intptr_t listener;
+        int hookId = -1;
+        std::mutex mtx{}, clientMtx{};
+        std::condition_variable cv{};
+        // staged by the UI thread, current and sent are encoder-owned
+        std::vector<Uint32> staged, current, sent;
+        SDL_Rect damage{};
+        bool newClient = false, quit = false;
+        std::vector<std::shared_ptr<Client>> clients{};
+        Uint32 frame = 0;
+        std::thread network{}, encoder{};
+    public:
+        FrameServer(Window &window, const std::string &address);
+        FrameServer(const FrameServer &) = delete;
+        FrameServer &operator=(const FrameServer &) = delete;
+        ~FrameServer();
+
+        inline bool isListening() const { return listener != -1; }
+        std::size_t clientCount();
+    private:
+        void capture(const SDL_Rect &region);
+        void serve();
+        void encode();
+        void appendTile(std::vector<Uint8> &out, Uint8 type, const SDL_Rect &tile, bool delta) const;
+        // false on a malformed message
+        bool readInput(Client &client);
+    };
+
+    // Local control endpoint for end-to-end tests and scripts: a line protocol on a
+    // TCP ("host:port") or UNIX ("unix:/path") socket, documented in sdlwin.cpp.
+    // Queries are answered from a snapshot of the component tree taken after every
+    // present, so clients never wait on the UI thread. Construct it on the UI thread;
+    // the Window must outlive the server.
+    class AutomationServer {
+    public:
+        struct Node {
+            // top-level id, then child indices: "list/2/0"
+            std::string id, value;
+            SDL_Rect rect;
+            bool visible;
+        };
+        struct Snapshot {
+            Uint32 frame = 0, presentedAt = 0;
+            // injected input batches the UI thread has handled
+            Uint32 inputs = 0;
+            std::vector<Node> nodes{};
+        };
+    private:
+        struct Wait {
+            enum Kind { NONE, FRAME, IDLE } kind = NONE;
+            Uint32 frame = 0, quietMs = 0, deadline = 0;
+        };
+        struct Client {
+            std::intptr_t sock;
+            std::vector<Uint8> input{};
+            Uint32 lastInput = 0;
+            Wait wait{};
+        };
+
+        Window &win;
+        std::string unixPath{};
+        std::intptr_t listener;
+        int hookId = -1;
+        Uint32 frame = 0, injected = 0;
+        // written by tasks posted to the UI thread, which may outlive the server
+        std::shared_ptr<std::atomic<Uint32>> applied;
+        // swapped atomically, never locked by the UI thread
+        std::shared_ptr<const Snapshot> current;
+        std::atomic<bool> quit{ false };
+        // the tree is only walked on present while someone can read it
+        std::atomic<int> connected{ 0 };
+        std::vector<Client> clients{};
+        std::thread network{};
+    public:
+        AutomationServer(Window &window, const std::string &address);
+        AutomationServer(const AutomationServer &) = delete;
+        AutomationServer &operator=(const AutomationServer &) = delete;
+        ~AutomationServer();
+
+        inline bool isListening() const { return listener != -1; }
+        // thread-safe, the tree as of the last present while a client was connected
+        inline std::shared_ptr<const Snapshot> snapshot() const { return std::atomic_load(&current); }
+    private:
+        void publish();
+        void serve();
+        // pushes the events and marks the batch handled once the UI thread has seen them
+        void inject(Client &client, std::initializer_list<SDL_Event> events);
+        // false while the client waits, the rest of its input is held back
+        bool command(Client &client, const std::string &line);
+        bool waitDone(Client &client);
+    };
+
+    // Renders many component trees to images at once, one thread per core. Each thread
+    // has its own headless Window and with it its own fonts and glyph and text caches;
+    // read-only resources such as a mounted AssetPack, the GlyphCache and frozen
+    // SdfFonts can be shared by the trees.
+    class BatchRenderer {
+    public:
+        // adds the components of one image to the thread's empty window
+        using Build = std::function<void(Window &, std::size_t)>;
+        // called on the rendering thread, the surface is drawn over once it returns
+        using Sink = std::function<void(std::size_t, const SDL_Surface *)>;
+    private:
+        int w, h;
+        unsigned threads;
+        Font fontName;
+        int fontSize;
+    public:
+        // 0 threads uses every core
+        BatchRenderer(int width, int height, unsigned threads = 0,
+            Font fontName = Font::CONSOLAS, int fontSize = 14);
+
+        inline unsigned threadCount() const { return threads; }
+        // images 0 to count - 1 in no particular order, blocks until all are done;
+        // false if a thread could not set up its window
+        bool render(std::size_t count, const Build &build, const Sink &sink);
+    };
 }
@@ -0,0 +1,34 @@
+// Packs directory trees into an sdlw asset pack.
+// usage: mkpack <pack> <dir>...
+// Files are named by their path relative to the directory they were found in,
+// with '/' separators, e.g. assets/fonts/arial.ttf becomes fonts/arial.ttf.
+#include "../sdlwin.hpp"
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    namespace fs = std::filesystem;
+    if (argc < 3) {
+        std::cerr << "usage: mkpack <pack> <dir>...\n";
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> files;
+    for (int i = 2; i < argc; ++i) {
+        const fs::path root = fs::u8path(argv[i]);
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec))
+            if (it->is_regular_file())
+                files.emplace_back(it->path().lexically_relative(root).generic_u8string(),
+                    it->path().u8string());
+        if (ec) {
+            std::cerr << "mkpack: " << argv[i] << ": " << ec.message() << '\n';
+            return 1;
+        }
+    }
+
+    if (!sdlw::AssetPack::build(argv[1], files))
+        return 1;
+    std::cout << files.size() << " files packed into " << argv[1] << '\n';
+    return 0;
+}